@@ -0,0 +1,164 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fb64.h"
+
+// Base16 (hex): RFC 4648 section 8.
+
+static const char hex_upper[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+static const char hex_lower[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+
+#if defined(__SSE2__)
+// Lanes of v in the range [lo, lo + span]: all ones, else zero.
+// SSE2 has no unsigned byte compare, but x <= span iff min(x, span) == x.
+static inline __m128i in_range(__m128i v, char lo, char span) {
+    __m128i x = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(span)), x);
+}
+
+// Nibbles to hex digits: '0' + n, plus `letters` (the distance from '9' + 1
+// to 'A' or 'a') for n > 9.
+static inline __m128i hex_digits(__m128i nibbles, char letters) {
+    __m128i above9 = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                        _mm_and_si128(above9, _mm_set1_epi8(letters)));
+}
+
+// Hex digits of either case to nibbles; lanes with anything else are
+// cleared in *valid.
+static inline __m128i hex_nibbles(__m128i v, __m128i *valid) {
+    const __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    const __m128i digit = in_range(v, '0', 9);
+    const __m128i letter = in_range(folded, 'a', 5);
+
+    *valid = _mm_and_si128(*valid, _mm_or_si128(digit, letter));
+
+    return _mm_or_si128(
+            _mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+            _mm_and_si128(letter, _mm_sub_epi8(folded, _mm_set1_epi8('a' - 10))));
+}
+#endif
+
+// Always inlined so that each caller gets the digits for its case folded in.
+__attribute__((always_inline))
+static inline void encode16(const uint8_t *buf, size_t len, char *out, const char digits[16]) {
+#if defined(__SSE2__)
+    const char letters = (char)(digits[10] - '9' - 1);
+
+    // 16 bytes at a time: split into high & low nibbles, interleaved so that
+    // each byte's high nibble comes first.
+    for (; len >= 16; buf += 16, out += 32, len -= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)buf);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+        const __m128i lo = _mm_and_si128(v, _mm_set1_epi8(0x0f));
+
+        _mm_storeu_si128((__m128i*)out, hex_digits(_mm_unpacklo_epi8(hi, lo), letters));
+        _mm_storeu_si128((__m128i*)(out + 16), hex_digits(_mm_unpackhi_epi8(hi, lo), letters));
+    }
+#endif
+
+    for (; len > 0; ++buf, out += 2, --len) {
+        out[0] = digits[*buf >> 4];
+        out[1] = digits[*buf & 15];
+    }
+}
+
+// Table-free hex digit value, like sextet() in decode.c.
+// Returns all bits set (so bit 4, which no nibble has) for anything but a
+// hex digit of either case. Unsigned so that it can be shifted either way.
+__attribute__((const))
+static unsigned nibble(unsigned char ch) {
+    const int c = ch;
+    int ret = -1;
+
+    ret += (((0x2f - c) & (c - 0x3a)) >> 8) & (c - 47); // 0-9: 0..9
+    ret += (((0x40 - c) & (c - 0x47)) >> 8) & (c - 54); // A-F: 10..15
+    ret += (((0x60 - c) & (c - 0x67)) >> 8) & (c - 86); // a-f: 10..15
+
+    return (unsigned)ret;
+}
+
+size_t fb64_base16_encoded_size(size_t input_len) {
+    return input_len * 2;
+}
+
+size_t fb64_base16_decoded_size(size_t inlen) {
+    return inlen / 2;
+}
+
+void fb64_base16_encode(const uint8_t *buf, size_t len, char *out) {
+    encode16(buf, len, out, hex_upper);
+}
+
+void fb64_base16_encode_lower(const uint8_t *buf, size_t len, char *out) {
+    encode16(buf, len, out, hex_lower);
+}
+
+int fb64_base16_decode(const char *in, size_t len, uint8_t *out) {
+    int bad = 0;
+
+    if (len % 2 != 0)
+        return 1;
+
+#if defined(__SSE2__)
+    __m128i valid = _mm_set1_epi8(-1);
+
+    // 32 digits at a time: in each 16-bit lane the first digit is in the low
+    // byte, so the byte is (lane & 0xff) << 4 | lane >> 8.
+    for (; len >= 32; in += 32, out += 16, len -= 32) {
+        const __m128i n0 = hex_nibbles(_mm_loadu_si128((const __m128i*)in), &valid);
+        const __m128i n1 = hex_nibbles(_mm_loadu_si128((const __m128i*)(in + 16)), &valid);
+        const __m128i b0 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(n0, _mm_set1_epi16(0xff)), 4),
+                                        _mm_srli_epi16(n0, 8));
+        const __m128i b1 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(n1, _mm_set1_epi16(0xff)), 4),
+                                        _mm_srli_epi16(n1, 8));
+
+        _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(b0, b1));
+    }
+
+    bad |= _mm_movemask_epi8(valid) != 0xffff;
+#endif
+
+    for (; len > 0; in += 2, ++out, len -= 2) {
+        const unsigned hi = nibble((unsigned char)in[0]);
+        const unsigned lo = nibble((unsigned char)in[1]);
+
+        // Valid nibbles never have bit 4 set; invalid ones do.
+        bad |= (hi | lo) & 16;
+        *out = (uint8_t)(hi << 4 | lo);
+    }
+
+    return bad != 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fb64.h"
+
+// Base32 & base32hex: RFC 4648 sections 6 & 7.
+// Each group of 5 bytes becomes 8 symbols of 5 bits. The 5-bit groups don't
+// line up with bytes, so rather than table lookups on individual bits the
+// group is processed as one 64-bit word (SWAR): the 40 bits are spread out
+// into a byte per symbol, or gathered back, in three halving steps.
+
+// Symbol values by character, for both alphabets & either case.
+// 0xff for characters outside the alphabet.
+static uint8_t b32[256], b32hex[256];
+
+__attribute__((constructor))
+static void setup_tables() {
+    memset(b32, 0xff, sizeof(b32));
+    memset(b32hex, 0xff, sizeof(b32hex));
+
+    for (unsigned i = 0; i < 26; ++i) {
+        b32['A' + i] = b32['a' + i] = (uint8_t)i;
+        if (i < 22)
+            b32hex['A' + i] = b32hex['a' + i] = (uint8_t)(10 + i);
+    }
+
+    for (unsigned i = 0; i < 10; ++i) {
+        if (i >= 2 && i <= 7)
+            b32['0' + i] = (uint8_t)(24 + i);
+        b32hex['0' + i] = (uint8_t)i;
+    }
+}
+
+#define ONES UINT64_C(0x0101010101010101)
+
+// Symbol values (one per byte) to ASCII, 8 at a time. Bytes at or above
+// `split` are found by adding 0x80 - split & testing the top bit; no byte
+// carries into the next because values are < 32.
+static inline uint64_t symbols(uint64_t v, bool hex) {
+    const uint64_t high = ((v + (0x80 - (hex ? 10 : 26)) * ONES) & 0x80 * ONES) >> 7;
+
+    if (hex)
+        return v + '0' * ONES + high * ('A' - 10 - '0');       // 0-9, A-V
+    else
+        return v + 'A' * ONES - high * ('A' - ('2' - 26));     // A-Z, 2-7
+}
+
+static inline void enc_group(const uint8_t in[5], char out[8], bool hex) {
+    const uint64_t v = (uint64_t)in[0] << 32 | (uint64_t)in[1] << 24 |
+                       (uint64_t)in[2] << 16 | (uint64_t)in[3] << 8 | in[4];
+
+    // 40 bits -> 2 x 20 in 32-bit lanes -> 4 x 10 in 16-bit lanes -> 8 x 5 in
+    // bytes, the most significant part going to the lowest lane each time.
+    const uint64_t a = v >> 20 | (v & 0xfffff) << 32;
+    const uint64_t b = (a >> 10 & UINT64_C(0x000003ff000003ff)) | (a & UINT64_C(0x000003ff000003ff)) << 16;
+    const uint64_t c = (b >> 5 & UINT64_C(0x001f001f001f001f)) | (b & UINT64_C(0x001f001f001f001f)) << 8;
+    const uint64_t s = symbols(c, hex);
+
+    for (unsigned i = 0; i < 8; ++i)
+        out[i] = (char)(s >> (i * 8));
+}
+
+// Returns nonzero for invalid symbols.
+static inline int dec_group(const unsigned char in[8], uint8_t out[5], const uint8_t table[256]) {
+    uint64_t c = 0;
+    unsigned bad = 0;
+
+    for (unsigned i = 0; i < 8; ++i) {
+        const uint8_t s = table[in[i]];
+        bad |= s;
+        c |= (uint64_t)s << (i * 8);
+    }
+
+    // The reverse of enc_group()
+    const uint64_t b = (c & UINT64_C(0x001f001f001f001f)) << 5 | (c >> 8 & UINT64_C(0x001f001f001f001f));
+    const uint64_t a = (b & UINT64_C(0x000003ff000003ff)) << 10 | (b >> 16 & UINT64_C(0x000003ff000003ff));
+    const uint64_t v = (a & 0xfffff) << 20 | (a >> 32 & 0xfffff);
+
+    for (unsigned i = 0; i < 5; ++i)
+        out[i] = (uint8_t)(v >> (32 - i * 8));
+
+    // Valid symbols are < 32
+    return bad & 0x80;
+}
+
+// Always inlined so that the alphabet & padding are folded into each caller.
+__attribute__((always_inline))
+static inline void encode32(const uint8_t *buf, size_t len, char *out, bool hex, bool pad) {
+    for (; len >= 5; buf += 5, out += 8, len -= 5)
+        enc_group(buf, out, hex);
+
+    if (len) {
+        uint8_t local[5] = {0, 0, 0, 0, 0};
+        char local_out[8];
+        const size_t n = (len * 8 + 4) / 5;
+
+        memcpy(local, buf, len);
+        enc_group(local, local_out, hex);
+        memcpy(out, local_out, n);
+
+        if (pad)
+            memset(out + n, '=', 8 - n);
+    }
+}
+
+// Number of symbols in a final group, by decoded bytes
+static const unsigned char group_symbols[5] = {0, 2, 4, 5, 7};
+
+static inline int decode32(const char *in, size_t len, uint8_t *out, const uint8_t table[256]) {
+    int bad = 0;
+    size_t pad = 0;
+
+    // Padding completes the final group
+    while (pad < 6 && pad < len && in[len - pad - 1] == '=')
+        ++pad;
+
+    if (pad && len % 8 != 0)
+        return 1;
+
+    len -= pad;
+
+    for (; len >= 8; in += 8, out += 5, len -= 8)
+        bad |= dec_group((const unsigned char*)in, out, table);
+
+    if (len) {
+        const size_t n = len * 5 / 8;
+        unsigned char local[8];
+        uint8_t local_out[5];
+
+        if (group_symbols[n] != len)
+            return 1;
+
+        // Symbols past the end are the alphabet's zero
+        memset(local, table == b32hex ? '0' : 'A', sizeof(local));
+        memcpy(local, in, len);
+        bad |= dec_group(local, local_out, table);
+        memcpy(out, local_out, n);
+    }
+
+    return bad != 0;
+}
+
+// NOTE: This function is const
+size_t fb64_base32_encoded_size(size_t input_len) {
+    return (input_len + 4) / 5 * 8;
+}
+
+// NOTE: This function is const
+size_t fb64_base32_encoded_size_nopad(size_t input_len) {
+    return (input_len * 8 + 4) / 5;
+}
+
+// NOTE: This function is const
+size_t fb64_base32_decoded_size_nopad(size_t inlen) {
+    return inlen * 5 / 8;
+}
+
+// NOTE: This function is pure
+size_t fb64_base32_decoded_size(const char *input, size_t inlen) {
+    size_t pad = 0;
+
+    while (pad < 6 && pad < inlen && input[inlen - pad - 1] == '=')
+        ++pad;
+
+    return fb64_base32_decoded_size_nopad(inlen - pad);
+}
+
+void fb64_base32_encode(const uint8_t *buf, size_t len, char *out) {
+    encode32(buf, len, out, false, true);
+}
+
+void fb64_base32_encode_nopad(const uint8_t *buf, size_t len, char *out) {
+    encode32(buf, len, out, false, false);
+}
+
+void fb64_base32hex_encode(const uint8_t *buf, size_t len, char *out) {
+    encode32(buf, len, out, true, true);
+}
+
+void fb64_base32hex_encode_nopad(const uint8_t *buf, size_t len, char *out) {
+    encode32(buf, len, out, true, false);
+}
+
+int fb64_base32_decode(const char *in, size_t len, uint8_t *out) {
+    return decode32(in, len, out, b32);
+}
+
+int fb64_base32hex_decode(const char *in, size_t len, uint8_t *out) {
+    return decode32(in, len, out, b32hex);
+}
@@ -22,7 +22,13 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
 #include <string>
+#include <thread>
+#include <vector>
 #include <benchmark/benchmark.h>
 #include <boost/archive/iterators/base64_from_binary.hpp>
 #include <boost/archive/iterators/binary_from_base64.hpp>
@@ -58,6 +64,350 @@ static void BM_Decode(benchmark::State& state) {
 
 BENCHMARK(BM_Decode);
 
+static void BM_DecodeCold(benchmark::State& state) {
+    uint8_t decoded[sizeof(input)-1];
+    for (auto _: state) {
+        fb64_decode_cold(input, input_len, decoded);
+    }
+}
+
+BENCHMARK(BM_DecodeCold);
+
+// Touch a working set of `bytes` unrelated to fb64, as the rest of an
+// application would between occasional calls. The largest is bigger than the
+// CPU caches, so that the next call starts with the tables (and the input)
+// evicted; smaller ones only push them out of L1/L2.
+static void evict_caches(size_t bytes) {
+    static std::vector<char> junk(32 << 20);
+    for (size_t i = 0; i < bytes && i < junk.size(); i += 64)
+        ++junk[i];
+    benchmark::DoNotOptimize(junk.data());
+}
+
+// Time one call after touching state.range(0) kiB of unrelated memory.
+// Manual timing: only the call is measured, not the eviction.
+template <typename Call>
+static void cold_calls(benchmark::State& state, Call call) {
+    for (auto _: state) {
+        evict_caches(static_cast<size_t>(state.range(0)) << 10);
+        auto start = std::chrono::steady_clock::now();
+        call();
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+}
+
+// Working set sizes in kiB: about L2, about L3 & past any L3.
+#define COLD_ARGS ->Arg(256)->Arg(4 << 10)->Arg(32 << 10)->UseManualTime()->Iterations(1000)
+
+// Occasional-use callers typically decode something short: a 32-byte key.
+static const char short_input[] = "rGqUn3c9d0sI8qN2kZ4vQh7yT1mXb6fW0pLe5aJ/Hc8=";
+static const size_t short_input_len = sizeof(short_input) - 1;
+
+// Wide tables (fb64_decode), fixed-size & table-free (fb64_decode_cold)
+// kernels on the same key.
+template <int (*Decode)(const char*, size_t, uint8_t*)>
+static void BM_Decode_ColdCache(benchmark::State& state) {
+    uint8_t decoded[sizeof(short_input)-1];
+    cold_calls(state, [&] {
+        Decode(short_input, short_input_len, decoded);
+        benchmark::DoNotOptimize(decoded);
+    });
+}
+BENCHMARK_TEMPLATE(BM_Decode_ColdCache, fb64_decode) COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_Decode_ColdCache, fb64_decode_cold) COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_Decode_ColdCache, fb64_decode_32) COLD_ARGS;
+
+// The same key as hex, through the SSE2 kernel, which has no tables.
+static void BM_Base16_Decode_ColdCache(benchmark::State& state) {
+    uint8_t key[32], decoded[32];
+    char hex[64];
+    fb64_decode_32(short_input, short_input_len, key);
+    fb64_base16_encode(key, sizeof(key), hex);
+
+    cold_calls(state, [&] {
+        fb64_base16_decode(hex, sizeof(hex), decoded);
+        benchmark::DoNotOptimize(decoded);
+    });
+}
+BENCHMARK(BM_Base16_Decode_ColdCache) COLD_ARGS;
+
+template <void (*Encode)(const uint8_t*, size_t, char*)>
+static void BM_Encode_ColdCache(benchmark::State& state) {
+    uint8_t key[32];
+    char encoded[sizeof(short_input)-1];
+    fb64_decode_32(short_input, short_input_len, key);
+
+    cold_calls(state, [&] {
+        Encode(key, sizeof(key), encoded);
+        benchmark::DoNotOptimize(encoded);
+    });
+}
+BENCHMARK_TEMPLATE(BM_Encode_ColdCache, fb64_encode) COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_Encode_ColdCache, fb64_encode_base64url_nopad) COLD_ARGS;
+
+// Short inputs of mixed lengths (0-63 bytes, in a scrambled order), where
+// the tail handling is a big part of the work & its branches are hard to
+// predict. Lengths are of the raw data; decode inputs are its padded or
+// unpadded encoding.
+static const std::vector<size_t>& short_lengths() {
+    static std::vector<size_t> lengths = [] {
+        std::vector<size_t> v;
+        for (size_t i = 0; i < 1024; ++i)
+            v.push_back(i * 37 % 64);
+        return v;
+    }();
+    return lengths;
+}
+
+template <void (*Encode)(const uint8_t*, size_t, char*)>
+static void BM_Encode_Short(benchmark::State& state) {
+    char out[(64 + 2) / 3 * 4];
+
+    for (auto _: state) {
+        for (size_t len: short_lengths()) {
+            Encode(reinterpret_cast<const uint8_t*>(input), len, out);
+            benchmark::DoNotOptimize(out);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * short_lengths().size());
+}
+BENCHMARK_TEMPLATE(BM_Encode_Short, fb64_encode);
+BENCHMARK_TEMPLATE(BM_Encode_Short, fb64_encode_base64url_nopad);
+
+template <int (*Decode)(const char*, size_t, uint8_t*), bool Padded>
+static void BM_Decode_Short(benchmark::State& state) {
+    std::vector<std::string> encoded;
+    uint8_t out[64];
+
+    for (size_t len: short_lengths()) {
+        std::string e(fb64_encoded_size(len), '\0');
+        (Padded ? fb64_encode : fb64_encode_nopad)(reinterpret_cast<const uint8_t*>(input), len, e.data());
+        e.resize(Padded ? e.size() : fb64_encoded_size_nopad(len));
+        encoded.push_back(e);
+    }
+
+    for (auto _: state) {
+        for (const auto& e: encoded) {
+            Decode(e.data(), e.size(), out);
+            benchmark::DoNotOptimize(out);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK_TEMPLATE(BM_Decode_Short, fb64_decode, true);
+BENCHMARK_TEMPLATE(BM_Decode_Short, fb64_decode_nopad, false);
+
+// Padding & alphabet policies on the same (unpadded, standard alphabet)
+// input: 1 kiB without its trailing "==".
+template <int (*Decode)(const char*, size_t, uint8_t*)>
+static void BM_Decode_Policy(benchmark::State& state) {
+    uint8_t decoded[sizeof(input)-1];
+    for (auto _: state) {
+        Decode(input, input_len - 2, decoded);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Decode_Policy, fb64_decode);
+BENCHMARK_TEMPLATE(BM_Decode_Policy, fb64_decode_nopad);
+BENCHMARK_TEMPLATE(BM_Decode_Policy, fb64_decode_nopad_strict);
+
+static void BM_Classify(benchmark::State& state) {
+    for (auto _: state) {
+        benchmark::DoNotOptimize(fb64_classify(input, input_len));
+    }
+    state.SetBytesProcessed(state.iterations() * input_len);
+}
+
+BENCHMARK(BM_Classify);
+
+// Verifying a 32-byte MAC: decode to a buffer & memcmp() vs
+// fb64_decode_equals(). The argument is the index of the first wrong byte
+// (32 for none); fb64_decode_equals() should take the same time for all.
+static const char mac[] = "q3vGZ2I0k8Qb4v0vJ6l5uYw9yQm1mM4f0u7iZc1w3pE=";
+
+static void BM_Verify_Memcmp(benchmark::State& state) {
+    uint8_t expected[32], decoded[32];
+    fb64_decode(mac, sizeof(mac) - 1, expected);
+    if (state.range(0) < 32)
+        expected[state.range(0)] ^= 1;
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(fb64_decode(mac, sizeof(mac) - 1, decoded) == 0 &&
+                std::memcmp(decoded, expected, sizeof(expected)) == 0);
+    }
+}
+
+static void BM_Verify_Equals(benchmark::State& state) {
+    uint8_t expected[32];
+    fb64_decode(mac, sizeof(mac) - 1, expected);
+    if (state.range(0) < 32)
+        expected[state.range(0)] ^= 1;
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(fb64_decode_equals(mac, sizeof(mac) - 1, expected, sizeof(expected)));
+    }
+}
+
+BENCHMARK(BM_Verify_Memcmp)->Arg(0)->Arg(16)->Arg(32);
+BENCHMARK(BM_Verify_Equals)->Arg(0)->Arg(16)->Arg(32);
+
+// 64-bit IDs: the generic encoder on big-endian bytes, one ID at a time,
+// & in batches.
+static const std::vector<uint64_t>& id_values() {
+    static std::vector<uint64_t> ids = [] {
+        std::vector<uint64_t> v(1024);
+        for (size_t i = 0; i < v.size(); ++i)
+            v[i] = i * 0x9e3779b97f4a7c15u;
+        return v;
+    }();
+    return ids;
+}
+
+static void encode_ids_generic(const uint64_t *ids, size_t n, char *out) {
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t buf[8];
+        for (unsigned b = 0; b < 8; ++b)
+            buf[b] = static_cast<uint8_t>(ids[i] >> (56 - b * 8));
+        fb64_encode_base64url_nopad(buf, sizeof(buf), out + i * FB64_U64_LEN);
+    }
+}
+
+static void encode_ids_single(const uint64_t *ids, size_t n, char *out) {
+    for (size_t i = 0; i < n; ++i)
+        fb64_encode_u64(ids[i], out + i * FB64_U64_LEN);
+}
+
+template <void (*Encode)(const uint64_t*, size_t, char*)>
+static void BM_Encode_IDs(benchmark::State& state) {
+    const auto& ids = id_values();
+    std::string out(ids.size() * FB64_U64_LEN, '\0');
+
+    for (auto _: state) {
+        Encode(ids.data(), ids.size(), out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+BENCHMARK_TEMPLATE(BM_Encode_IDs, encode_ids_generic);
+BENCHMARK_TEMPLATE(BM_Encode_IDs, encode_ids_single);
+BENCHMARK_TEMPLATE(BM_Encode_IDs, fb64_encode_u64_batch);
+
+static int decode_ids_single(const char *in, size_t n, uint64_t *ids) {
+    int bad = 0;
+    for (size_t i = 0; i < n; ++i)
+        bad |= fb64_decode_u64(in + i * FB64_U64_LEN, FB64_U64_LEN, &ids[i]);
+    return bad;
+}
+
+template <int (*Decode)(const char*, size_t, uint64_t*)>
+static void BM_Decode_IDs(benchmark::State& state) {
+    const auto& ids = id_values();
+    std::string in(ids.size() * FB64_U64_LEN, '\0');
+    std::vector<uint64_t> out(ids.size());
+    fb64_encode_u64_batch(ids.data(), ids.size(), in.data());
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Decode(in.data(), ids.size(), out.data()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+BENCHMARK_TEMPLATE(BM_Decode_IDs, decode_ids_single);
+BENCHMARK_TEMPLATE(BM_Decode_IDs, fb64_decode_u64_batch);
+
+// A few IDs at a time, occasionally: scalar vs SSSE3 kernels with cold
+// caches.
+template <int (*Decode)(const char*, size_t, uint64_t*)>
+static void BM_Decode_IDs_ColdCache(benchmark::State& state) {
+    uint64_t ids[8];
+    char encoded[8 * FB64_U64_LEN];
+    for (size_t i = 0; i < 8; ++i)
+        ids[i] = 0x9e3779b97f4a7c15u * (i + 1);
+    fb64_encode_u64_batch(ids, 8, encoded);
+
+    cold_calls(state, [&] {
+        Decode(encoded, 8, ids);
+        benchmark::DoNotOptimize(ids);
+    });
+}
+BENCHMARK_TEMPLATE(BM_Decode_IDs_ColdCache, decode_ids_single) COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_Decode_IDs_ColdCache, fb64_decode_u64_batch) COLD_ARGS;
+
+// Base16 & base32 on the 1 kiB of decoded input, against byte-at-a-time
+// loops.
+static std::string raw_input() {
+    std::string bin(fb64_decoded_size(input, input_len), '\xff');
+    if (fb64_decode(input, input_len, reinterpret_cast<uint8_t*>(bin.data())) != 0)
+        throw std::runtime_error("Decode failure");
+    return bin;
+}
+
+static void hex_encode_bytewise(const uint8_t *buf, size_t len, char *out) {
+    static const char digits[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < len; ++i) {
+        out[i * 2] = digits[buf[i] >> 4];
+        out[i * 2 + 1] = digits[buf[i] & 15];
+    }
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+static int hex_decode_bytewise(const char *in, size_t len, uint8_t *out) {
+    if (len % 2)
+        return 1;
+    for (size_t i = 0; i < len / 2; ++i) {
+        const int hi = hex_digit(in[i * 2]), lo = hex_digit(in[i * 2 + 1]);
+        if (hi < 0 || lo < 0)
+            return 1;
+        out[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return 0;
+}
+
+template <void (*Encode)(const uint8_t*, size_t, char*), size_t (*Size)(size_t)>
+static void BM_Encode_Base16_32(benchmark::State& state) {
+    const std::string bin = raw_input();
+    std::string encoded(Size(bin.size()), '\0');
+
+    for (auto _: state) {
+        Encode(reinterpret_cast<const uint8_t*>(bin.data()), bin.size(), encoded.data());
+        benchmark::DoNotOptimize(encoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * bin.size());
+}
+BENCHMARK_TEMPLATE(BM_Encode_Base16_32, hex_encode_bytewise, fb64_base16_encoded_size);
+BENCHMARK_TEMPLATE(BM_Encode_Base16_32, fb64_base16_encode, fb64_base16_encoded_size);
+BENCHMARK_TEMPLATE(BM_Encode_Base16_32, fb64_base32_encode, fb64_base32_encoded_size);
+BENCHMARK_TEMPLATE(BM_Encode_Base16_32, fb64_base32hex_encode_nopad, fb64_base32_encoded_size_nopad);
+
+template <void (*Encode)(const uint8_t*, size_t, char*), size_t (*Size)(size_t),
+         int (*Decode)(const char*, size_t, uint8_t*)>
+static void BM_Decode_Base16_32(benchmark::State& state) {
+    const std::string bin = raw_input();
+    std::string encoded(Size(bin.size()), '\0');
+    std::string decoded(bin.size(), '\0');
+    Encode(reinterpret_cast<const uint8_t*>(bin.data()), bin.size(), encoded.data());
+
+    for (auto _: state) {
+        Decode(encoded.data(), encoded.size(), reinterpret_cast<uint8_t*>(decoded.data()));
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * bin.size());
+}
+BENCHMARK_TEMPLATE(BM_Decode_Base16_32, fb64_base16_encode, fb64_base16_encoded_size, hex_decode_bytewise);
+BENCHMARK_TEMPLATE(BM_Decode_Base16_32, fb64_base16_encode, fb64_base16_encoded_size, fb64_base16_decode);
+BENCHMARK_TEMPLATE(BM_Decode_Base16_32, fb64_base32_encode, fb64_base32_encoded_size, fb64_base32_decode);
+BENCHMARK_TEMPLATE(BM_Decode_Base16_32, fb64_base32hex_encode_nopad, fb64_base32_encoded_size_nopad, fb64_base32hex_decode);
+
 static void BM_Decode_String(benchmark::State& state) {
     std::string in(input);
     std::string out;
@@ -113,6 +463,56 @@ static void fb64_Encode(benchmark::State& state) {
 }
 BENCHMARK(fb64_Encode);
 
+// Fixed-size functions vs the generic ones at the same sizes:
+// UUIDs, 256-bit keys, 512-bit signatures.
+template <size_t N, void (*Encode)(const uint8_t*, char*)>
+static void BM_Encode_Fixed(benchmark::State& state) {
+    uint8_t bin[N];
+    char encoded[(N + 2) / 3 * 4];
+    for (size_t i = 0; i < N; ++i)
+        bin[i] = static_cast<uint8_t>(i * 37);
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(bin);
+        Encode(bin, encoded);
+        benchmark::DoNotOptimize(encoded);
+    }
+}
+
+template <size_t N>
+static void generic_encode(const uint8_t *buf, char *out) {
+    fb64_encode_base64url_nopad(buf, N, out);
+}
+
+BENCHMARK_TEMPLATE(BM_Encode_Fixed, 16, generic_encode<16>);
+BENCHMARK_TEMPLATE(BM_Encode_Fixed, 16, fb64_encode_base64url_nopad_16);
+BENCHMARK_TEMPLATE(BM_Encode_Fixed, 32, generic_encode<32>);
+BENCHMARK_TEMPLATE(BM_Encode_Fixed, 32, fb64_encode_base64url_nopad_32);
+BENCHMARK_TEMPLATE(BM_Encode_Fixed, 64, generic_encode<64>);
+BENCHMARK_TEMPLATE(BM_Encode_Fixed, 64, fb64_encode_base64url_nopad_64);
+
+template <size_t N, int (*Decode)(const char*, size_t, uint8_t*)>
+static void BM_Decode_Fixed(benchmark::State& state) {
+    uint8_t bin[N];
+    char encoded[(N + 2) / 3 * 4];
+    for (size_t i = 0; i < N; ++i)
+        bin[i] = static_cast<uint8_t>(i * 37);
+    fb64_encode(bin, N, encoded);
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(encoded);
+        Decode(encoded, sizeof(encoded), bin);
+        benchmark::DoNotOptimize(bin);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Decode_Fixed, 16, fb64_decode);
+BENCHMARK_TEMPLATE(BM_Decode_Fixed, 16, fb64_decode_16);
+BENCHMARK_TEMPLATE(BM_Decode_Fixed, 32, fb64_decode);
+BENCHMARK_TEMPLATE(BM_Decode_Fixed, 32, fb64_decode_32);
+BENCHMARK_TEMPLATE(BM_Decode_Fixed, 64, fb64_decode);
+BENCHMARK_TEMPLATE(BM_Decode_Fixed, 64, fb64_decode_64);
+
 static void BoostEncode(benchmark::State& state) {
     std::string bin(fb64_decoded_size(input, input_len), '\xff');
     if (fb64_decode(input, input_len, reinterpret_cast<uint8_t*>(bin.data())) != 0)
@@ -139,4 +539,209 @@ static void modp_Encode(benchmark::State& state) {
 }
 BENCHMARK(modp_Encode);
 
+// Large-buffer encode & decode, much bigger than the last-level cache.
+// Compares regular & non-temporal stores. mem_bw counts both the bytes read
+// and written.
+static const size_t large_len = 64 << 20;
+
+static const std::vector<uint8_t>& large_raw() {
+    static std::vector<uint8_t> raw = [] {
+        std::vector<uint8_t> v(large_len);
+        for (size_t i = 0; i < v.size(); ++i)
+            v[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+        return v;
+    }();
+    return raw;
+}
+
+static const std::string& large_encoded() {
+    static std::string encoded = [] {
+        std::string e(fb64_encoded_size(large_len), '\0');
+        fb64_encode_nt(large_raw().data(), large_len, e.data());
+        return e;
+    }();
+    return encoded;
+}
+
+// The regular functions switch to non-temporal stores on their own at
+// fb64_nontemporal_threshold(), so the cached baselines work in chunks just
+// under it.
+static void encode_cached(const uint8_t *buf, size_t len, char *out) {
+    const size_t chunk = (fb64_nontemporal_threshold() - 1) / 3 * 3;
+    for (; len > chunk; len -= chunk, buf += chunk, out += chunk / 3 * 4)
+        fb64_encode_base64url(buf, chunk, out);
+    fb64_encode_base64url(buf, len, out);
+}
+
+static int decode_cached(const char *in, size_t len, uint8_t *out) {
+    const size_t chunk = (fb64_nontemporal_threshold() - 1) / 4 * 4;
+    int bad = 0;
+    for (; len > chunk; len -= chunk, in += chunk, out += chunk / 4 * 3)
+        bad |= fb64_decode(in, chunk, out);
+    return bad | fb64_decode(in, len, out);
+}
+
+template <void (*Encode)(const uint8_t*, size_t, char*)>
+static void BM_Encode_Large(benchmark::State& state) {
+    const auto& raw = large_raw();
+    std::string encoded(fb64_encoded_size(raw.size()), '\0');
+
+    for (auto _: state) {
+        Encode(raw.data(), raw.size(), encoded.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * raw.size());
+    state.counters["mem_bw"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * (raw.size() + encoded.size())),
+            benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
+}
+BENCHMARK_TEMPLATE(BM_Encode_Large, encode_cached);
+BENCHMARK_TEMPLATE(BM_Encode_Large, fb64_encode_base64url_nt);
+
+template <int (*Decode)(const char*, size_t, uint8_t*)>
+static void BM_Decode_Large(benchmark::State& state) {
+    const auto& encoded = large_encoded();
+    std::vector<uint8_t> decoded(fb64_decoded_size(encoded.data(), encoded.size()));
+
+    for (auto _: state) {
+        Decode(encoded.data(), encoded.size(), decoded.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * encoded.size());
+    state.counters["mem_bw"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * (encoded.size() + decoded.size())),
+            benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
+}
+BENCHMARK_TEMPLATE(BM_Decode_Large, decode_cached);
+BENCHMARK_TEMPLATE(BM_Decode_Large, fb64_decode_nt);
+
+// Effect on a neighbouring workload: how long a pass over a 1 MiB working
+// set takes right after a large encode. With regular stores the encode
+// output evicts it; with non-temporal stores it should stay cached.
+template <void (*Encode)(const uint8_t*, size_t, char*)>
+static void BM_Encode_Large_Neighbour(benchmark::State& state) {
+    const auto& raw = large_raw();
+    std::string encoded(fb64_encoded_size(raw.size()), '\0');
+    std::vector<uint64_t> hot((1 << 20) / sizeof(uint64_t), 1);
+
+    for (auto _: state) {
+        Encode(raw.data(), raw.size(), encoded.data());
+        benchmark::ClobberMemory();
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t sum = 0;
+        for (uint64_t v: hot)
+            sum += v;
+        benchmark::DoNotOptimize(sum);
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+}
+BENCHMARK_TEMPLATE(BM_Encode_Large_Neighbour, encode_cached)->UseManualTime()->Iterations(20);
+BENCHMARK_TEMPLATE(BM_Encode_Large_Neighbour, fb64_encode_base64url_nt)->UseManualTime()->Iterations(20);
+
+// Multi-core scaling: the same codec on 1..N threads at once, at several
+// buffer sizes. With private buffers each thread has its own input & output;
+// with shared buffers all threads read one input & write adjacent slices of
+// one output buffer, as a parallel API splitting one job would.
+// bytes_per_second is the aggregate over all threads. efficiency is the
+// average thread's throughput relative to a lone thread (1.0 is perfect
+// scaling); it's only reported after the 1-thread run of the same size.
+
+enum class buffers { PRIVATE, SHARED };
+
+static const int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+static const size_t max_scaling_len = 4 << 20;
+
+static const uint8_t *scaling_raw() {
+    return large_raw().data();
+}
+
+static const char *scaling_encoded() {
+    static const std::string encoded = [] {
+        std::string e(fb64_encoded_size(max_scaling_len), '\0');
+        fb64_encode(scaling_raw(), max_scaling_len, e.data());
+        return e;
+    }();
+    return encoded.data();
+}
+
+static char *shared_output() {
+    static std::vector<char> out(fb64_encoded_size(max_scaling_len) * max_threads);
+    return out.data();
+}
+
+// Runs one thread's share of a scaling benchmark. op(in, out) processes
+// `len` bytes of input.
+template <typename Op>
+static void run_scaling(benchmark::State& state, buffers buf, const char *in,
+        size_t out_len, std::map<int64_t, double>& lone_rate, Op op) {
+    const size_t len = static_cast<size_t>(state.range(0));
+    std::vector<char> private_in, private_out;
+    char *out;
+
+    if (buf == buffers::PRIVATE) {
+        private_in.assign(in, in + len);
+        private_out.resize(out_len);
+        in = private_in.data();
+        out = private_out.data();
+    } else {
+        out = shared_output() + out_len * state.thread_index();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto _: state) {
+        op(in, out);
+        benchmark::ClobberMemory();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const double rate = static_cast<double>(state.iterations() * len) /
+        std::chrono::duration<double>(end - start).count();
+
+    state.SetBytesProcessed(state.iterations() * len);
+
+    // Only the single-thread run writes to the map; threads of the other
+    // runs only look the rate up, so they never modify it concurrently.
+    if (state.threads() == 1) {
+        lone_rate[state.range(0)] = rate;
+    } else {
+        const auto lone = lone_rate.find(state.range(0));
+        if (lone != lone_rate.end())
+            state.counters["efficiency"] = benchmark::Counter(
+                    rate / lone->second, benchmark::Counter::kAvgThreads);
+    }
+}
+
+template <buffers Buf>
+static void BM_Encode_Scaling(benchmark::State& state) {
+    static std::map<int64_t, double> lone_rate;
+    const size_t len = static_cast<size_t>(state.range(0));
+
+    run_scaling(state, Buf, reinterpret_cast<const char*>(scaling_raw()),
+            fb64_encoded_size(len), lone_rate, [len](const char *in, char *out) {
+        fb64_encode(reinterpret_cast<const uint8_t*>(in), len, out);
+    });
+}
+
+template <buffers Buf>
+static void BM_Decode_Scaling(benchmark::State& state) {
+    static std::map<int64_t, double> lone_rate;
+    const size_t len = static_cast<size_t>(state.range(0));
+
+    run_scaling(state, Buf, scaling_encoded(), len / 4 * 3, lone_rate,
+            [len](const char *in, char *out) {
+        fb64_decode(in, len, reinterpret_cast<uint8_t*>(out));
+    });
+}
+
+#define SCALING_ARGS ->Arg(1 << 10)->Arg(64 << 10)->Arg(max_scaling_len) \
+    ->ThreadRange(1, max_threads)->UseRealTime()
+BENCHMARK_TEMPLATE(BM_Encode_Scaling, buffers::PRIVATE) SCALING_ARGS;
+BENCHMARK_TEMPLATE(BM_Encode_Scaling, buffers::SHARED) SCALING_ARGS;
+BENCHMARK_TEMPLATE(BM_Decode_Scaling, buffers::PRIVATE) SCALING_ARGS;
+BENCHMARK_TEMPLATE(BM_Decode_Scaling, buffers::SHARED) SCALING_ARGS;
+
 BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fb64.h"
+
+__attribute__((const))
+static unsigned classify_symbol(unsigned char c) {
+    if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+        return 0;
+    if (c == '+' || c == '/')
+        return FB64_CLASS_STANDARD;
+    if (c == '-' || c == '_')
+        return FB64_CLASS_URL;
+    return FB64_CLASS_BAD_SYMBOL;
+}
+
+#if defined(__SSE2__)
+// Lanes of v in the range [lo, lo + span]: all ones, else zero.
+// SSE2 has no unsigned byte compare, but x <= span iff min(x, span) == x.
+static inline __m128i in_range(__m128i v, char lo, char span) {
+    __m128i x = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(span)), x);
+}
+
+static inline __m128i eq(__m128i v, char c) {
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+#endif
+
+// Classify symbols (excluding padding) 16 at a time.
+static unsigned classify_symbols(const char *in, size_t len) {
+    unsigned result = 0;
+
+#if defined(__SSE2__)
+    __m128i standard = _mm_setzero_si128();
+    __m128i url = _mm_setzero_si128();
+    __m128i valid = _mm_set1_epi8(-1);
+
+    for (; len >= 16; in += 16, len -= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)in);
+        __m128i s = _mm_or_si128(eq(v, '+'), eq(v, '/'));
+        __m128i u = _mm_or_si128(eq(v, '-'), eq(v, '_'));
+        __m128i alnum = _mm_or_si128(
+                _mm_or_si128(in_range(v, 'A', 25), in_range(v, 'a', 25)),
+                in_range(v, '0', 9));
+
+        standard = _mm_or_si128(standard, s);
+        url = _mm_or_si128(url, u);
+        valid = _mm_and_si128(valid, _mm_or_si128(alnum, _mm_or_si128(s, u)));
+    }
+
+    if (_mm_movemask_epi8(standard))
+        result |= FB64_CLASS_STANDARD;
+    if (_mm_movemask_epi8(url))
+        result |= FB64_CLASS_URL;
+    if (_mm_movemask_epi8(valid) != 0xffff)
+        result |= FB64_CLASS_BAD_SYMBOL;
+#endif
+
+    for (; len > 0; ++in, --len)
+        result |= classify_symbol((unsigned char)*in);
+
+    return result;
+}
+
+// NOTE: This function is pure
+unsigned fb64_classify(const char *in, size_t len) {
+    unsigned result = 0;
+    size_t pad = 0;
+
+    while (pad < 2 && pad < len && in[len - pad - 1] == '=')
+        ++pad;
+
+    if (pad > 0) {
+        result |= FB64_CLASS_PADDED;
+        if (len % 4 != 0)
+            result |= FB64_CLASS_BAD_LENGTH;
+    }
+
+    len -= pad;
+
+    switch (len % 4) {
+    case 1:
+        result |= FB64_CLASS_BAD_LENGTH;
+        break;
+    case 2:
+    case 3:
+        if (!pad)
+            result |= FB64_CLASS_UNPADDED;
+        break;
+    }
+
+    return result | classify_symbols(in, len);
+}
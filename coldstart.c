@@ -0,0 +1,201 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// First-call latency: the cost of the first encode or decode after process
+// start, as seen by a short-lived process or one that only uses fb64
+// occasionally. Each sample is a new process, so it includes fb64's table
+// setup (the setup_tables() constructors) & the page faults & cache misses
+// of touching the tables & code for the first time.
+//
+// Usage: coldstart [RUNS]   run each kernel in RUNS new processes (default
+//                           100) & print the median & 90th percentile times
+//        coldstart KERNEL   take one sample of KERNEL & print its times
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fb64.h"
+
+static struct timespec process_start;
+
+// Runs before fb64's constructors, which have the default (lowest) priority
+__attribute__((constructor(101)))
+static void mark_start(void) {
+    clock_gettime(CLOCK_MONOTONIC, &process_start);
+}
+
+static long elapsed_ns(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000000L + (to->tv_nsec - from->tv_nsec);
+}
+
+// A 32-byte key, as in benchmark.cpp's cold-cache benchmarks
+static const char key[] = "rGqUn3c9d0sI8qN2kZ4vQh7yT1mXb6fW0pLe5aJ/Hc8=";
+static const char key_hex[] = "AC6A949F773D774B08F2A376919E2F421EF24F59976FA7D6D292DEE5A27F1DCF";
+// IDs 1-4
+static const char ids[] = "AAAAAAAAAAE" "AAAAAAAAAAI" "AAAAAAAAAAM" "AAAAAAAAAAQ";
+_Static_assert(sizeof ids - 1 == 4 * FB64_U64_LEN, "ids must hold 4 encoded IDs");
+
+static uint8_t out[64];
+static char text[64];
+static uint64_t id_out[4];
+
+static int decode(void) { return fb64_decode(key, sizeof(key) - 1, out); }
+static int decode_cold(void) { return fb64_decode_cold(key, sizeof(key) - 1, out); }
+static int decode_32(void) { return fb64_decode_32(key, sizeof(key) - 1, out); }
+static int base16_decode(void) { return fb64_base16_decode(key_hex, sizeof(key_hex) - 1, out); }
+static int encode(void) { fb64_encode(out, 32, text); return 0; }
+static int decode_u64(void) { return fb64_decode_u64(ids, FB64_U64_LEN, id_out); }
+static int decode_u64_batch(void) { return fb64_decode_u64_batch(ids, 4, id_out); }
+
+static const struct {
+    const char *name;
+    int (*call)(void);
+} kernels[] = {
+    { "decode", decode },                     // wide tables
+    { "decode_cold", decode_cold },           // table-free
+    { "decode_32", decode_32 },               // fixed-size, unrolled
+    { "base16_decode", base16_decode },       // SSE2
+    { "encode", encode },
+    { "decode_u64", decode_u64 },             // scalar
+    { "decode_u64_batch", decode_u64_batch }, // SSSE3
+};
+
+#define NKERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+// Sample mode: startup (constructors), first call & second call, in ns
+static int sample(const char *name) {
+    for (size_t k = 0; k < NKERNELS; ++k) {
+        if (strcmp(kernels[k].name, name) != 0)
+            continue;
+
+        struct timespec t_main, t_first, t_second;
+        int bad;
+
+        clock_gettime(CLOCK_MONOTONIC, &t_main);
+        bad = kernels[k].call();
+        clock_gettime(CLOCK_MONOTONIC, &t_first);
+        bad |= kernels[k].call();
+        clock_gettime(CLOCK_MONOTONIC, &t_second);
+
+        if (bad) {
+            fprintf(stderr, "%s: Decode error\n", name);
+            return 2;
+        }
+
+        printf("%ld %ld %ld\n", elapsed_ns(&process_start, &t_main),
+                elapsed_ns(&t_main, &t_first), elapsed_ns(&t_first, &t_second));
+        return 0;
+    }
+
+    fprintf(stderr, "Unknown kernel %s\n", name);
+    return 1;
+}
+
+// Run a sample in a new process (the same executable) & read its times
+static int run_sample(const char *name, long times[3]) {
+    int fds[2];
+    FILE *f;
+    pid_t pid;
+    int status, n;
+
+    if (pipe(fds) != 0)
+        return -1;
+
+    pid = fork();
+    if (pid < 0)
+        return -1;
+
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl("/proc/self/exe", "coldstart", name, (char*)NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    f = fdopen(fds[0], "r");
+    n = f ? fscanf(f, "%ld %ld %ld", &times[0], &times[1], &times[2]) : 0;
+    if (f)
+        fclose(f);
+    else
+        close(fds[0]);
+
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return -1;
+
+    return n == 3 ? 0 : -1;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    const long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && (argv[1][0] < '0' || argv[1][0] > '9'))
+        return sample(argv[1]);
+
+    const int runs = argc > 1 ? atoi(argv[1]) : 100;
+    long *times = malloc(sizeof(long) * 3 * (runs > 0 ? runs : 1));
+
+    if (runs <= 0 || !times) {
+        fprintf(stderr, "Usage: %s [RUNS | KERNEL]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-18s %21s %21s %21s\n", "kernel (ns)", "startup med/p90",
+            "first call med/p90", "second call med/p90");
+
+    for (size_t k = 0; k < NKERNELS; ++k) {
+        long sample_times[3];
+
+        for (int r = 0; r < runs; ++r) {
+            if (run_sample(kernels[k].name, sample_times) != 0) {
+                fprintf(stderr, "%s: Sample failed\n", kernels[k].name);
+                free(times);
+                return 2;
+            }
+            for (int c = 0; c < 3; ++c)
+                times[c * runs + r] = sample_times[c];
+        }
+
+        printf("%-18s", kernels[k].name);
+        for (int c = 0; c < 3; ++c) {
+            long *col = times + c * runs;
+            qsort(col, (size_t)runs, sizeof(long), cmp_long);
+            printf(" %10ld/%10ld", col[runs / 2], col[runs * 9 / 10]);
+        }
+        printf("\n");
+    }
+
+    free(times);
+    return 0;
+}
@@ -22,9 +22,22 @@
  * SOFTWARE.
  */
 
+#include <stdbool.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// SSSE3 kernels are built with the target attribute & chosen at run time,
+// so the library still runs on CPUs without SSSE3.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_SSSE3_KERNELS
+#include <tmmintrin.h>
+#endif
+
 #include "fb64.h"
+#include "nontemporal.h"
 
 // Future: These tables can be hard-coded
 // rather than built at startup.
@@ -44,6 +57,12 @@
 // having to be shifted.
 static uint8_t t0[256], t1[256], t2[256], t3[256];
 
+// Alphabet-specific symbols, for strict decoding.
+// The decode tables accept both alphabets equally.
+#define ALPHA_BASE64    (1 << 0) // + & /
+#define ALPHA_BASE64URL (1 << 1) // - & _
+static uint8_t alpha[256];
+
 // Bad bits
 #define T0BB (1 << 0)
 #define T1BB (1 << 2)
@@ -111,6 +130,9 @@ static void setup_tables() {
     t2['_'] = splitshift_t2(63);
     t3['-'] = 62;
     t3['_'] = 63;
+
+    alpha['+'] = alpha['/'] = ALPHA_BASE64;
+    alpha['-'] = alpha['_'] = ALPHA_BASE64URL;
 }
 
 // The number of bytes expected in the last block, based on the *unpadded*
@@ -164,57 +186,586 @@ static int decode_block(const unsigned char in[4], uint8_t out[3]) {
            (t3[in[3]] & T3BB);
 }
 
-// Returns nonzero on invalid input.
-// output buffer *must* have enough space.
-// Use fb64_decode_size() or fb64_decode_size_nopad() to determine
-// the output buffer size based on the input length.
-int fb64_decode(const char *in, size_t len, uint8_t *out) {
+// Table-free equivalent of the t0-t3 lookups: maps a base64 or base64url
+// symbol to its 6-bit value using range comparisons only, so decoding does
+// not need to pull the tables into cache.
+// Each range test produces either 0 or -1 (all bits set) from the sign of
+// (lo - c) & (c - hi), which is negative only when lo < c < hi.
+// Returns all bits set (so bit 6, which no sextet has) for symbols outside
+// both alphabets (including '='). The result is unsigned so that callers can
+// shift it whether it's valid or not.
+__attribute__((const))
+static unsigned sextet(unsigned char ch) {
+    const int c = ch;
+    int ret = -1;
+
+    ret += (((0x40 - c) & (c - 0x5b)) >> 8) & (c - 64); // A-Z: 0..25
+    ret += (((0x60 - c) & (c - 0x7b)) >> 8) & (c - 70); // a-z: 26..51
+    ret += (((0x2f - c) & (c - 0x3a)) >> 8) & (c + 5);  // 0-9: 52..61
+    ret += (((0x2a - c) & (c - 0x2c)) >> 8) & 63;       // '+': 62
+    ret += (((0x2e - c) & (c - 0x30)) >> 8) & 64;       // '/': 63
+    ret += (((0x2c - c) & (c - 0x2e)) >> 8) & 63;       // '-': 62
+    ret += (((0x5e - c) & (c - 0x60)) >> 8) & 64;       // '_': 63
+
+    return (unsigned)ret;
+}
+
+static int decode_block_notable(const unsigned char in[4], uint8_t out[3]) {
+    const unsigned a = sextet(in[0]);
+    const unsigned b = sextet(in[1]);
+    const unsigned c = sextet(in[2]);
+    const unsigned d = sextet(in[3]);
+
+    out[0] = (uint8_t)(a << 2 | b >> 4);
+    out[1] = (uint8_t)(b << 4 | c >> 2);
+    out[2] = (uint8_t)(c << 6 | d);
+
+    // Valid sextets never have bit 6 set; invalid ones do.
+    return (a | b | c | d) & 64;
+}
+
+typedef int (*decode_block_func)(const unsigned char in[4], uint8_t out[3]);
+
+// Bits from the alpha table for the symbols of a block.
+static unsigned block_alpha(const unsigned char in[4]) {
+    return alpha[in[0]] | alpha[in[1]] | alpha[in[2]] | alpha[in[3]];
+}
+
+// Shared body of the decoders. Always inlined so that each caller gets its
+// own copy with the block decoder & these policies resolved at compile time:
+// padded: whether input may be padded. Unpadded-only input can decode all
+//         full blocks in place, skipping the final block copy entirely when
+//         the input is a whole number of blocks.
+// forbidden: ALPHA_ bits of the alphabet to reject for strict decoding,
+//         or 0 to accept both. Strict decoding of padded input also
+//         requires the padding.
+__attribute__((always_inline))
+static inline int decode(const char *in, size_t len, uint8_t *out,
+        decode_block_func decode_block, bool padded, unsigned forbidden) {
     int bad = 0;
+    unsigned seen = 0;
+
+    if (forbidden && padded && len % 4 != 0)
+        return 1;
 
-    // if your input is always unpadded you can avoid the copy-decode-copy cycle
-    // after the loop 25% of the time by changing the condition to `len > 3`,
-    // but for possibly-padded input the last block has to do the
+    // For possibly-padded input the last block has to do the
     // copy-decode-copy operation to avoid overrunning the output buffer if
     // there's padding.
 
-    while (len > 4) {
+    while (len > (padded ? 4 : 3)) {
         bad |= decode_block((const unsigned char*)in, out);
+        if (forbidden)
+            seen |= block_alpha((const unsigned char*)in);
         len -= 4;
         in += 4;
         out += 3;
     }
 
-    // Final block (which might be a full block, or might include padding)
-    // When padded we determine the actual output length (by counting
-    // padding symbols) and replace padding with 'A's to avoid decode failure.
-    // Unpadded input is unmodified.
+    // Only empty input has no final block
+    if (len == 0)
+        return bad | ((seen & forbidden) != 0);
 
-    unsigned char block_in[4] = {'A', 'A', 'A', 'A'};
-    uint8_t block_out[3];
+    // Final block (which might be a full block, or might include padding),
+    // assembled without copying the input or branching on its length:
+    // each symbol is loaded from an index clamped to the input & replaced by
+    // an 'A' (zero bits) if it's past the end, or padding when padded.
 
-    memcpy(block_in, in, len);
+    unsigned char block_in[4];
+    uint8_t block_out[3];
 
-    // strip padding before final block decode
-    // if your input is never padded then you can delete these operations,
-    // other than the check for truncated input (len == 1)
-    // and go straight to the decode_block call.
-    if (len == 4 && in[3] == '=') {
-        --len;
-        block_in[3] = 'A';
+    for (size_t i = 0; i < 4; ++i) {
+        const size_t inside = -(size_t)(i < len);
+        const unsigned char c = (unsigned char)in[(i & inside) | ((len - 1) & ~inside)];
+        block_in[i] = (unsigned char)((c & inside) | ('A' & ~inside));
     }
 
-    if (len == 3 && in[2] == '=') {
-        --len;
-        block_in[2] = 'A';
+    // Padding is turned into an 'A' by flipping the bits that differ
+    if (padded) {
+        const unsigned pad3 = (len == 4) & (block_in[3] == '=');
+        len -= pad3;
+        block_in[3] ^= (unsigned char)(-pad3 & ('=' ^ 'A'));
+
+        const unsigned pad2 = (len == 3) & (block_in[2] == '=');
+        len -= pad2;
+        block_in[2] ^= (unsigned char)(-pad2 & ('=' ^ 'A'));
     }
 
-    if (__builtin_expect(len == 1 || (len == 2 && block_in[1] == '='), 0)) {
+    if (__builtin_expect((len == 1) | ((len == 2) & (block_in[1] == '=')), 0)) {
         // short input; won't trigger a badbit
         return 1;
     }
 
     bad |= decode_block(block_in, block_out);
-    memcpy(out, block_out, last_block_decoded_len(len));
+    if (forbidden)
+        seen |= block_alpha(block_in);
+
+    // Store the 1-3 decoded bytes back to front, clamping the index so that
+    // surplus bytes land on a position that's overwritten afterwards.
+    const size_t last = last_block_decoded_len(len) - 1;
+    for (size_t i = 3; i-- > 0;)
+        out[i < last ? i : last] = block_out[i];
+
+    return bad | ((seen & forbidden) != 0);
+}
+
+// Decode with non-temporal stores: 16 blocks at a time are decoded into a
+// local buffer & streamed out to memory as 48 bytes, bypassing the cache.
+// Input is prefetched with a non-temporal hint for the same reason.
+static int decode_nt(const char *in, size_t len, uint8_t *out) {
+    int bad = 0;
+
+#if defined(__SSE2__)
+    // Output advances 3 bytes per block, so within 16 blocks it will reach
+    // the 16-byte alignment needed by streaming stores.
+    while (len > 4 && ((uintptr_t)out & 15) != 0) {
+        bad |= decode_block((const unsigned char*)in, out);
+        len -= 4;
+        in += 4;
+        out += 3;
+    }
+
+    // Keep the final block for decode() which handles padding.
+    while (len > 64) {
+        __m128i line[3];
+
+        __builtin_prefetch(in + NT_PREFETCH_DISTANCE, 0, 0);
+
+        for (unsigned i = 0; i < 16; ++i)
+            bad |= decode_block((const unsigned char*)in + i * 4, (uint8_t*)line + i * 3);
+
+        for (unsigned i = 0; i < 3; ++i)
+            _mm_stream_si128((__m128i*)out + i, line[i]);
+
+        len -= 64;
+        in += 64;
+        out += 48;
+    }
+
+    _mm_sfence();
+#endif
+
+    return bad | decode(in, len, out, decode_block, true, 0);
+}
+
+// Decode the encoding of a compile-time constant number of bytes as
+// straight-line code. Accepts the padded or unpadded encoding; anything
+// else is invalid.
+// None of the fixed sizes are a multiple of 3, so the final block is
+// always partial.
+__attribute__((always_inline))
+static inline int decode_fixed(const char *in, size_t len, uint8_t *out, size_t n) {
+    const size_t nopad_len = (n * 4 + 2) / 3;
+    const size_t pad_len = (n + 2) / 3 * 4;
+    int bad = 0;
+
+    if (len == pad_len) {
+        for (size_t i = nopad_len; i < pad_len; ++i)
+            bad |= in[i] != '=';
+    } else if (len != nopad_len) {
+        return 1;
+    }
+
+#pragma GCC unroll 32
+    for (size_t i = 0; i < n / 3; ++i)
+        bad |= decode_block((const unsigned char*)in + i * 4, out + i * 3);
+
+    unsigned char block_in[4] = {'A', 'A', 'A', 'A'};
+    uint8_t block_out[3];
+
+    memcpy(block_in, in + n / 3 * 4, nopad_len % 4);
+    bad |= decode_block(block_in, block_out);
+    memcpy(out + n / 3 * 3, block_out, n % 3);
+
+    return bad;
+}
+
+int fb64_decode_16(const char *in, size_t len, uint8_t out[16]) {
+    return decode_fixed(in, len, out, 16);
+}
+
+int fb64_decode_32(const char *in, size_t len, uint8_t out[32]) {
+    return decode_fixed(in, len, out, 32);
+}
+
+int fb64_decode_64(const char *in, size_t len, uint8_t out[64]) {
+    return decode_fixed(in, len, out, 64);
+}
+
+// Integer IDs: strict, unpadded base64url of the big-endian bytes.
+// The spare low bits of the final symbol must be 0, so that each ID has only
+// one valid encoding.
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (unsigned i = 0; i < 8; ++i)
+        v = v << 8 | p[i];
+    return v;
+}
+
+int fb64_decode_u64(const char *in, size_t len, uint64_t *id) {
+    uint8_t buf[8];
+
+    if (len != FB64_U64_LEN)
+        return 1;
+
+    int bad = decode(in, FB64_U64_LEN, buf, decode_block, false, ALPHA_BASE64);
+    bad |= t3[(unsigned char)in[FB64_U64_LEN - 1]] & 3;
+
+    *id = load_be64(buf);
+    return bad;
+}
+
+int fb64_decode_u128(const char *in, size_t len, uint64_t *hi, uint64_t *lo) {
+    uint8_t buf[16];
+
+    if (len != FB64_U128_LEN)
+        return 1;
+
+    int bad = decode(in, FB64_U128_LEN, buf, decode_block, false, ALPHA_BASE64);
+    bad |= t3[(unsigned char)in[FB64_U128_LEN - 1]] & 15;
+
+    *hi = load_be64(buf);
+    *lo = load_be64(buf + 8);
+    return bad;
+}
+
+#ifdef HAVE_SSSE3_KERNELS
+// Decode 16 base64url symbols to 12 bytes (in the low 12 bytes of the
+// result). Symbols are mapped to sextets by range comparisons; lanes holding
+// anything else are cleared in *valid. The sextets are then multiplied &
+// added into 24-bit groups & shuffled into byte order.
+__attribute__((target("ssse3")))
+static __m128i dec_vec_url(__m128i in, __m128i *valid) {
+#define IN_RANGE(lo, hi) _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8((lo) - 1)), \
+                                       _mm_cmplt_epi8(in, _mm_set1_epi8((hi) + 1)))
+    const __m128i upper = IN_RANGE('A', 'Z');
+    const __m128i lower = IN_RANGE('a', 'z');
+    const __m128i digit = IN_RANGE('0', '9');
+    const __m128i dash = _mm_cmpeq_epi8(in, _mm_set1_epi8('-'));
+    const __m128i underscore = _mm_cmpeq_epi8(in, _mm_set1_epi8('_'));
+#undef IN_RANGE
+
+    const __m128i offset = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                         _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+            _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                         _mm_or_si128(_mm_and_si128(dash, _mm_set1_epi8(62 - '-')),
+                                      _mm_and_si128(underscore, _mm_set1_epi8(63 - '_')))));
+
+    *valid = _mm_and_si128(*valid, _mm_or_si128(_mm_or_si128(upper, lower),
+                _mm_or_si128(digit, _mm_or_si128(dash, underscore))));
+
+    const __m128i sextets = _mm_add_epi8(in, offset);
+    const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+    const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+    return _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+// Load the `n` symbols at `in` & fill the rest of the vector with 'A's
+// (zero bits). Reads 16 bytes directly if `end` allows.
+__attribute__((target("ssse3")))
+static __m128i load_symbols(const char *in, size_t n, const char *end) {
+    if (end - in >= 16) {
+        const __m128i keep = _mm_cmpgt_epi8(_mm_set1_epi8((char)n),
+                _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        return _mm_or_si128(_mm_and_si128(keep, _mm_loadu_si128((const __m128i*)in)),
+                            _mm_andnot_si128(keep, _mm_set1_epi8('A')));
+    }
+
+    char buf[16];
+    memset(buf, 'A', sizeof(buf));
+    memcpy(buf, in, n);
+    return _mm_loadu_si128((const __m128i*)buf);
+}
+
+__attribute__((target("ssse3")))
+static int decode_u64_ssse3(const char *in, size_t n, uint64_t *ids) {
+    const char *const end = in + n * FB64_U64_LEN;
+    __m128i valid = _mm_set1_epi8(-1);
+    int bad = 0;
+
+    for (; in < end; in += FB64_U64_LEN, ++ids) {
+        uint8_t buf[16];
+        _mm_storeu_si128((__m128i*)buf, dec_vec_url(load_symbols(in, FB64_U64_LEN, end), &valid));
+        *ids = load_be64(buf);
+        // spare bits of the final symbol
+        bad |= buf[8];
+    }
+
+    return bad | (_mm_movemask_epi8(valid) != 0xffff);
+}
+
+__attribute__((target("ssse3")))
+static int decode_u128_ssse3(const char *in, size_t n, uint64_t *ids) {
+    const char *const end = in + n * FB64_U128_LEN;
+    __m128i valid = _mm_set1_epi8(-1);
+    int bad = 0;
+
+    for (; in < end; in += FB64_U128_LEN, ids += 2) {
+        uint8_t buf[28];
+        _mm_storeu_si128((__m128i*)buf, dec_vec_url(_mm_loadu_si128((const __m128i*)in), &valid));
+        _mm_storeu_si128((__m128i*)(buf + 12),
+                dec_vec_url(load_symbols(in + 16, FB64_U128_LEN - 16, end), &valid));
+        ids[0] = load_be64(buf);
+        ids[1] = load_be64(buf + 8);
+        bad |= buf[16];
+    }
+
+    return bad | (_mm_movemask_epi8(valid) != 0xffff);
+}
+#endif
+
+int fb64_decode_u64_batch(const char *in, size_t n, uint64_t *ids) {
+    int bad = 0;
+
+#ifdef HAVE_SSSE3_KERNELS
+    if (__builtin_cpu_supports("ssse3"))
+        return decode_u64_ssse3(in, n, ids);
+#endif
+
+    for (size_t i = 0; i < n; ++i)
+        bad |= fb64_decode_u64(in + i * FB64_U64_LEN, FB64_U64_LEN, &ids[i]);
+
+    return bad;
+}
+
+int fb64_decode_u128_batch(const char *in, size_t n, uint64_t *ids) {
+    int bad = 0;
+
+#ifdef HAVE_SSSE3_KERNELS
+    if (__builtin_cpu_supports("ssse3"))
+        return decode_u128_ssse3(in, n, ids);
+#endif
+
+    for (size_t i = 0; i < n; ++i)
+        bad |= fb64_decode_u128(in + i * FB64_U128_LEN, FB64_U128_LEN, &ids[i * 2], &ids[i * 2 + 1]);
+
+    return bad;
+}
+
+__attribute__((const))
+static int hexval(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Decodes the JSON escape sequence after a backslash into the character it
+// stands for. Only \/ and \u00XX (ASCII) escapes can stand for base64
+// symbols, so others are rejected.
+// Returns the length of the escape sequence (not counting the backslash),
+// or 0 if it's invalid.
+static size_t json_unescape(const char *in, size_t len, char *c) {
+    if (len >= 1 && in[0] == '/') {
+        *c = '/';
+        return 1;
+    }
+
+    if (len >= 5 && in[0] == 'u' && in[1] == '0' && in[2] == '0') {
+        int hi = hexval(in[3]), lo = hexval(in[4]);
+        if (hi >= 0 && hi < 8 && lo >= 0) {
+            *c = (char)(hi << 4 | lo);
+            return 5;
+        }
+    }
 
+    return 0;
+}
+
+int fb64_decode_json(const char *in, size_t len, uint8_t *out, size_t *outlen) {
+    const char *const end = in + len;
+    const char *bs = memchr(in, '\\', len);
+    uint8_t *const out_start = out;
+    char block[4];
+    size_t n = 0; // symbols collected in block
+    int bad = 0;
+
+    while (in < end) {
+        if (n == 0) {
+            // Nothing escaped in the rest of the input (the common case
+            // for the whole input): decode it in place.
+            if (!bs) {
+                size_t rest = (size_t)(end - in);
+                bad |= decode(in, rest, out, decode_block, true, 0);
+                out += fb64_decoded_size(in, rest);
+                break;
+            }
+
+            // Whole blocks before the next escape can be decoded in place
+            // too. None of them is the final block.
+            while (bs - in >= 4) {
+                bad |= decode_block((const unsigned char*)in, out);
+                in += 4;
+                out += 3;
+            }
+        }
+
+        if (in == bs) {
+            size_t esc = json_unescape(in + 1, (size_t)(end - in - 1), &block[n]);
+            if (esc == 0) {
+                bad = 1;
+                break;
+            }
+
+            in += 1 + esc;
+            bs = memchr(in, '\\', (size_t)(end - in));
+        } else {
+            block[n] = *in++;
+        }
+
+        // Full blocks with more input after them can't be padded.
+        // The final block is left for decode() which handles padding.
+        if (++n == 4 && in < end) {
+            bad |= decode_block((const unsigned char*)block, out);
+            out += 3;
+            n = 0;
+        }
+    }
+
+    if (n > 0 && !bad) {
+        bad |= decode(block, n, out, decode_block, true, 0);
+        out += fb64_decoded_size(block, n);
+    }
+
+    *outlen = (size_t)(out - out_start);
     return bad;
 }
+
+// Table-free decode for constant time. Only lengths (& so the amount of
+// padding) affect the flow of control.
+int fb64_decode_equals(const char *in, size_t len, const uint8_t *expected, size_t expected_len) {
+    const unsigned char *s = (const unsigned char*)in;
+    unsigned bad = 0, diff = 0;
+
+    // Strip padding like decode() does: from the final block only
+    if (len % 4 == 0 && len > 0 && in[len - 1] == '=')
+        --len;
+    if (len % 4 == 3 && in[len - 1] == '=')
+        --len;
+
+    if (len % 4 == 1 || fb64_decoded_size_nopad(len) != expected_len)
+        return 1;
+
+    for (; len >= 4; len -= 4, s += 4, expected += 3) {
+        const unsigned a = sextet(s[0]), b = sextet(s[1]), c = sextet(s[2]), d = sextet(s[3]);
+
+        bad |= (a | b | c | d) & 64;
+        diff |= (uint8_t)(a << 2 | b >> 4) ^ expected[0];
+        diff |= (uint8_t)(b << 4 | c >> 2) ^ expected[1];
+        diff |= (uint8_t)(c << 6 | d) ^ expected[2];
+    }
+
+    if (len >= 2) {
+        const unsigned a = sextet(s[0]), b = sextet(s[1]);
+        const unsigned c = len == 3 ? sextet(s[2]) : 0;
+
+        bad |= (a | b | c) & 64;
+        diff |= (uint8_t)(a << 2 | b >> 4) ^ expected[0];
+        if (len == 3)
+            diff |= (uint8_t)(b << 4 | c >> 2) ^ expected[1];
+    }
+
+    return (bad | diff) != 0;
+}
+
+// Delimiters are found with memchr(), which libc vectorizes, & each record
+// goes straight through the bulk decode kernel, so the input is only read
+// once.
+size_t fb64_decode_records(const char *in, size_t len, char delim, uint8_t *out,
+        struct fb64_record *records, size_t max_records, size_t *consumed) {
+    const char *const start = in;
+    const char *const end = in + len;
+    uint8_t *const out_start = out;
+    size_t n = 0;
+
+    while (in < end && n < max_records) {
+        const char *next = memchr(in, delim, (size_t)(end - in));
+        size_t reclen = (size_t)((next ? next : end) - in);
+        struct fb64_record *rec = &records[n++];
+
+        if (delim == '\n' && reclen > 0 && in[reclen - 1] == '\r')
+            --reclen;
+
+        rec->offset = (size_t)(out - out_start);
+        rec->len = 0;
+        rec->err = decode(in, reclen, out, decode_block, true, 0);
+        if (!rec->err) {
+            rec->len = fb64_decoded_size(in, reclen);
+            out += rec->len;
+        }
+
+        in = next ? next + 1 : end;
+    }
+
+    if (consumed)
+        *consumed = (size_t)(in - start);
+
+    return n;
+}
+
+// If the rest of the input doesn't fit, only whole blocks that fit are
+// decoded. The final block then can't be among them: it would have to be
+// the one that doesn't fit, so they're decoded as unpadded input, which
+// also rejects padding in them.
+int fb64_decode_partial(const char *in, size_t len, uint8_t *out, size_t outcap,
+        size_t *consumed, size_t *produced) {
+    const size_t total = fb64_decoded_size(in, len);
+    const bool last = total <= outcap;
+    const size_t inlen = last ? len : outcap / 3 * 4;
+    int bad;
+
+    *consumed = 0;
+    *produced = 0;
+
+    bad = decode(in, inlen, out, decode_block, last, 0);
+    if (bad)
+        return bad;
+
+    *consumed = inlen;
+    *produced = last ? total : inlen / 4 * 3;
+    return 0;
+}
+
+// Returns nonzero on invalid input.
+// output buffer *must* have enough space.
+// Use fb64_decode_size() or fb64_decode_size_nopad() to determine
+// the output buffer size based on the input length.
+int fb64_decode(const char *in, size_t len, uint8_t *out) {
+    if (len >= FB64_NONTEMPORAL_THRESHOLD)
+        return decode_nt(in, len, out);
+
+    return decode(in, len, out, decode_block, true, 0);
+}
+
+int fb64_decode_cold(const char *in, size_t len, uint8_t *out) {
+    return decode(in, len, out, decode_block_notable, true, 0);
+}
+
+int fb64_decode_nt(const char *in, size_t len, uint8_t *out) {
+    return decode_nt(in, len, out);
+}
+
+int fb64_decode_nopad(const char *in, size_t len, uint8_t *out) {
+    return decode(in, len, out, decode_block, false, 0);
+}
+
+int fb64_decode_strict(const char *in, size_t len, uint8_t *out) {
+    return decode(in, len, out, decode_block, true, ALPHA_BASE64URL);
+}
+
+int fb64_decode_nopad_strict(const char *in, size_t len, uint8_t *out) {
+    return decode(in, len, out, decode_block, false, ALPHA_BASE64URL);
+}
+
+int fb64_decode_base64url_strict(const char *in, size_t len, uint8_t *out) {
+    return decode(in, len, out, decode_block, true, ALPHA_BASE64);
+}
+
+int fb64_decode_base64url_nopad_strict(const char *in, size_t len, uint8_t *out) {
+    return decode(in, len, out, decode_block, false, ALPHA_BASE64);
+}
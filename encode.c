@@ -27,7 +27,19 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// SSSE3 kernels are built with the target attribute & chosen at run time,
+// so the library still runs on CPUs without SSSE3.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_SSSE3_KERNELS
+#include <tmmintrin.h>
+#endif
+
 #include "fb64.h"
+#include "nontemporal.h"
 
 static const char b64[64] = {
     'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
@@ -55,7 +67,10 @@ static void enc_block(const char table[64], const uint8_t bytes[3], char dest[4]
     dest[3] = table[(bytes[2] & 63)];
 }
 
-static void encode(const uint8_t *buf, size_t len, char *out, const char table[64], bool pad) {
+// Always inlined so that constant arguments (table, padding & for the
+// fixed-size functions, the length) are folded into each caller.
+__attribute__((always_inline))
+static inline void encode(const uint8_t *buf, size_t len, char *out, const char table[64], bool pad) {
     while (len >= 3) {
         enc_block(table, buf, out);
         buf += 3;
@@ -63,48 +78,292 @@ static void encode(const uint8_t *buf, size_t len, char *out, const char table[6
         len -= 3;
     }
 
+    // Final 1 or 2 bytes, encoded without a temporary copy or branching on
+    // the length: the second byte's load is clamped to the input & masked
+    // off if it's past the end.
     if (len) {
-        uint8_t local[3] = {0,0,0};
-        char local_out[4];
-        memcpy(local, buf, len);
-
-        enc_block(table, local, local_out);
-
-        switch (len) {
-        case 2:
-            out[2] = local_out[2];
-            /* fallthrough */
-        case 1:
-            out[1] = local_out[1];
-            out[0] = local_out[0];
-        }
+        const unsigned two = -(unsigned)(len > 1);
+        const uint8_t b0 = buf[0];
+        const uint8_t b1 = buf[len - 1] & two;
+        const char s0 = table[b0 >> 2];
+        const char s1 = table[((b0 & 3) << 4) | (b1 >> 4)];
+        const char s2 = table[(b1 & 15) << 2];
 
         if (pad) {
-            switch (len) {
-            case 1:
-                out[2] = '=';
-                /* fallthrough */
-            case 2:
-                out[3] = '=';
-            }
+            out[3] = '=';
+            out[2] = (char)(((unsigned)s2 & two) | ('=' & ~two));
+        } else {
+            // Lands on out[1] for 1 byte, to be overwritten below
+            out[len] = s2;
+        }
+
+        out[1] = s1;
+        out[0] = s0;
+    }
+}
+
+// Encode with non-temporal stores: 16 blocks at a time are encoded into a
+// local buffer & streamed out to memory as 64 bytes, bypassing the cache.
+// Input is prefetched with a non-temporal hint for the same reason.
+static void encode_nt(const uint8_t *buf, size_t len, char *out, const char table[64], bool pad) {
+#if defined(__SSE2__)
+    // Streaming stores need 16-byte alignment, which is reachable if the
+    // output is 4-byte aligned.
+    while (len >= 3 && ((uintptr_t)out & 15) != 0) {
+        enc_block(table, buf, out);
+        buf += 3;
+        out += 4;
+        len -= 3;
+    }
+
+    if (((uintptr_t)out & 15) == 0) {
+        while (len >= 48) {
+            __m128i line[4];
+
+            __builtin_prefetch(buf + NT_PREFETCH_DISTANCE, 0, 0);
+
+            for (unsigned i = 0; i < 16; ++i)
+                enc_block(table, buf + i * 3, (char*)line + i * 4);
+
+            for (unsigned i = 0; i < 4; ++i)
+                _mm_stream_si128((__m128i*)out + i, line[i]);
+
+            buf += 48;
+            out += 64;
+            len -= 48;
         }
+
+        _mm_sfence();
     }
+#endif
+
+    encode(buf, len, out, table, pad);
 }
 
 void fb64_encode(const uint8_t *buf, size_t len, char *out) {
-    encode(buf, len, out, b64, true);
+    if (len >= FB64_NONTEMPORAL_THRESHOLD)
+        encode_nt(buf, len, out, b64, true);
+    else
+        encode(buf, len, out, b64, true);
 }
 
 void fb64_encode_nopad(const uint8_t *buf, size_t len, char *out) {
-    encode(buf, len, out, b64, false);
+    if (len >= FB64_NONTEMPORAL_THRESHOLD)
+        encode_nt(buf, len, out, b64, false);
+    else
+        encode(buf, len, out, b64, false);
 }
 
 void fb64_encode_base64url(const uint8_t *buf, size_t len, char *out) {
-    encode(buf, len, out, b64url, true);
+    if (len >= FB64_NONTEMPORAL_THRESHOLD)
+        encode_nt(buf, len, out, b64url, true);
+    else
+        encode(buf, len, out, b64url, true);
 }
 
 void fb64_encode_base64url_nopad(const uint8_t *buf, size_t len, char *out) {
-    encode(buf, len, out, b64url, false);
+    if (len >= FB64_NONTEMPORAL_THRESHOLD)
+        encode_nt(buf, len, out, b64url, false);
+    else
+        encode(buf, len, out, b64url, false);
+}
+
+void fb64_encode_nt(const uint8_t *buf, size_t len, char *out) {
+    encode_nt(buf, len, out, b64, true);
+}
+
+void fb64_encode_nopad_nt(const uint8_t *buf, size_t len, char *out) {
+    encode_nt(buf, len, out, b64, false);
+}
+
+void fb64_encode_base64url_nt(const uint8_t *buf, size_t len, char *out) {
+    encode_nt(buf, len, out, b64url, true);
+}
+
+void fb64_encode_base64url_nopad_nt(const uint8_t *buf, size_t len, char *out) {
+    encode_nt(buf, len, out, b64url, false);
+}
+
+// Encode a compile-time constant number of bytes as straight-line code:
+// the block loop is fully unrolled & the tail handling is resolved at
+// compile time.
+__attribute__((always_inline))
+static inline void encode_fixed(const uint8_t *buf, size_t len, char *out, const char table[64], bool pad) {
+#pragma GCC unroll 32
+    for (size_t i = 0; i < len / 3; ++i)
+        enc_block(table, buf + i * 3, out + i * 4);
+
+    encode(buf + len / 3 * 3, len % 3, out + len / 3 * 4, table, pad);
+}
+
+#define FB64_ENCODE_FIXED(n) \
+    void fb64_encode_##n(const uint8_t buf[n], char *out) { \
+        encode_fixed(buf, n, out, b64, true); \
+    } \
+    void fb64_encode_nopad_##n(const uint8_t buf[n], char *out) { \
+        encode_fixed(buf, n, out, b64, false); \
+    } \
+    void fb64_encode_base64url_##n(const uint8_t buf[n], char *out) { \
+        encode_fixed(buf, n, out, b64url, true); \
+    } \
+    void fb64_encode_base64url_nopad_##n(const uint8_t buf[n], char *out) { \
+        encode_fixed(buf, n, out, b64url, false); \
+    }
+
+FB64_ENCODE_FIXED(16)
+FB64_ENCODE_FIXED(32)
+FB64_ENCODE_FIXED(64)
+
+// Integer IDs are the big-endian bytes of the integer, encoded as unpadded
+// base64url.
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+    for (unsigned i = 0; i < 8; ++i)
+        p[i] = (uint8_t)(v >> (56 - i * 8));
+}
+
+void fb64_encode_u64(uint64_t id, char out[FB64_U64_LEN]) {
+    uint8_t buf[8];
+    store_be64(buf, id);
+    encode_fixed(buf, sizeof(buf), out, b64url, false);
+}
+
+void fb64_encode_u128(uint64_t hi, uint64_t lo, char out[FB64_U128_LEN]) {
+    uint8_t buf[16];
+    store_be64(buf, hi);
+    store_be64(buf + 8, lo);
+    encode_fixed(buf, sizeof(buf), out, b64url, false);
+}
+
+#ifdef HAVE_SSSE3_KERNELS
+// Encode the first 12 bytes of `in` as 16 base64url symbols: 4 blocks of
+// enc_block() at once. Each block's bytes are spread over a 32-bit lane &
+// multiplied so that each sextet lands in its own byte, then each sextet is
+// turned into a symbol by adding an offset looked up by its range.
+__attribute__((target("ssse3")))
+static __m128i enc_vec_url(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    const __m128i ac = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                                       _mm_set1_epi32(0x04000040));
+    const __m128i bd = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                                       _mm_set1_epi32(0x01000010));
+    const __m128i sextets = _mm_or_si128(ac, bd);
+
+    // Offset index: A-Z: 13, a-z: 0, 0-9: 1..10, '-': 11, '_': 12
+    __m128i idx = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+    idx = _mm_or_si128(idx, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), sextets),
+                                          _mm_set1_epi8(13)));
+
+    const __m128i offsets = _mm_setr_epi8('a' - 26,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '-' - 62, '_' - 63, 'A', 0, 0);
+
+    return _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, idx));
+}
+
+// Each ID's 16-byte store runs into the next ID's output, which is written
+// afterwards; only the last ID goes via a local buffer.
+__attribute__((target("ssse3")))
+static void encode_u64_ssse3(const uint64_t *ids, size_t n, char *out) {
+    for (; n > 0; --n, ++ids, out += FB64_U64_LEN) {
+        uint8_t buf[8];
+        store_be64(buf, *ids);
+        const __m128i enc = enc_vec_url(_mm_loadl_epi64((const __m128i*)buf));
+
+        if (n > 1) {
+            _mm_storeu_si128((__m128i*)out, enc);
+        } else {
+            char last[16];
+            _mm_storeu_si128((__m128i*)last, enc);
+            memcpy(out, last, FB64_U64_LEN);
+        }
+    }
+}
+
+__attribute__((target("ssse3")))
+static void encode_u128_ssse3(const uint64_t *ids, size_t n, char *out) {
+    for (; n > 0; --n, ids += 2, out += FB64_U128_LEN) {
+        uint8_t buf[16];
+        store_be64(buf, ids[0]);
+        store_be64(buf + 8, ids[1]);
+        const __m128i in = _mm_loadu_si128((const __m128i*)buf);
+        const __m128i lo = enc_vec_url(in);
+        const __m128i hi = enc_vec_url(_mm_srli_si128(in, 12));
+
+        if (n > 1) {
+            _mm_storeu_si128((__m128i*)out, lo);
+            _mm_storeu_si128((__m128i*)(out + 16), hi);
+        } else {
+            char last[32];
+            _mm_storeu_si128((__m128i*)last, lo);
+            _mm_storeu_si128((__m128i*)(last + 16), hi);
+            memcpy(out, last, FB64_U128_LEN);
+        }
+    }
+}
+#endif
+
+void fb64_encode_u64_batch(const uint64_t *ids, size_t n, char *out) {
+#ifdef HAVE_SSSE3_KERNELS
+    if (__builtin_cpu_supports("ssse3")) {
+        encode_u64_ssse3(ids, n, out);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < n; ++i)
+        fb64_encode_u64(ids[i], out + i * FB64_U64_LEN);
+}
+
+void fb64_encode_u128_batch(const uint64_t *ids, size_t n, char *out) {
+#ifdef HAVE_SSSE3_KERNELS
+    if (__builtin_cpu_supports("ssse3")) {
+        encode_u128_ssse3(ids, n, out);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < n; ++i)
+        fb64_encode_u128(ids[i * 2], ids[i * 2 + 1], out + i * FB64_U128_LEN);
+}
+
+// Delimiters are found with memchr(), as in fb64_decode_records(), & each
+// record goes straight through the encode kernel.
+size_t fb64_encode_records(const uint8_t *in, size_t len, char delim, unsigned flags,
+        char *out, struct fb64_record *records, size_t max_records, size_t *consumed) {
+    const uint8_t *const start = in;
+    const uint8_t *const end = in + len;
+    char *const out_start = out;
+    const char *const table = flags & FB64_RECORD_URL ? b64url : b64;
+    const bool pad = !(flags & FB64_RECORD_NOPAD);
+    size_t n = 0;
+
+    while (in < end && n < max_records) {
+        const uint8_t *next = memchr(in, delim, (size_t)(end - in));
+        const size_t reclen = (size_t)((next ? next : end) - in);
+        struct fb64_record *rec = &records[n++];
+
+        rec->offset = (size_t)(out - out_start);
+        rec->len = pad ? fb64_encoded_size(reclen) : fb64_encoded_size_nopad(reclen);
+        rec->err = 0;
+
+        encode(in, reclen, out, table, pad);
+        out += rec->len;
+
+        in = next ? next + 1 : end;
+    }
+
+    if (consumed)
+        *consumed = (size_t)(in - start);
+
+    return n;
+}
+
+// NOTE: This function is const
+size_t fb64_nontemporal_threshold(void) {
+    return FB64_NONTEMPORAL_THRESHOLD;
 }
 
 // NOTE: This function is const
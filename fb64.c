@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -150,14 +151,163 @@ static int encode(encodefunc_t encode_func) {
     }
 }
 
+// Records mode: one record per line, each encoded or decoded on its own.
+
+struct records {
+    encodefunc_t encode_func;
+    size_t line;    // number of the first line of the next batch
+    bool failed;    // some record was invalid
+    void *buf;      // output buffer, grown as needed
+    size_t bufsize;
+};
+
+static void *records_buf(struct records *rec, size_t size) {
+    if (size > rec->bufsize) {
+        void *buf = realloc(rec->buf, size);
+        if (!buf)
+            return NULL;
+        rec->buf = buf;
+        rec->bufsize = size;
+    }
+
+    return rec->buf;
+}
+
+static int decode_records(struct records *rec, const char *in, size_t len) {
+    struct fb64_record records[1024];
+    uint8_t *out = records_buf(rec, fb64_decoded_size_nopad(len));
+
+    if (!out && len > 0) {
+        perror("Out of memory");
+        return 1;
+    }
+
+    while (len > 0) {
+        size_t consumed;
+        size_t n = fb64_decode_records(in, len, '\n', out, records,
+                sizeof(records) / sizeof(records[0]), &consumed);
+
+        for (size_t i = 0; i < n; ++i, ++rec->line) {
+            if (records[i].err) {
+                fprintf(stderr, "Decode error on line %zu\n", rec->line);
+                rec->failed = true;
+                continue;
+            }
+
+            fwrite(out + records[i].offset, 1, records[i].len, stdout);
+            putchar('\n');
+        }
+
+        in += consumed;
+        len -= consumed;
+    }
+
+    return 0;
+}
+
+static int encode_records(struct records *rec, const char *in, size_t len) {
+    struct fb64_record records[1024];
+    const encodefunc_t f = rec->encode_func;
+    const unsigned flags =
+        (f == fb64_encode_base64url || f == fb64_encode_base64url_nopad ? FB64_RECORD_URL : 0) |
+        (f == fb64_encode_nopad || f == fb64_encode_base64url_nopad ? FB64_RECORD_NOPAD : 0);
+    char *out = records_buf(rec, len * 2 + 2);
+
+    if (!out) {
+        perror("Out of memory");
+        return 1;
+    }
+
+    while (len > 0) {
+        size_t consumed;
+        size_t n = fb64_encode_records((const uint8_t*)in, len, '\n', flags, out, records,
+                sizeof(records) / sizeof(records[0]), &consumed);
+
+        for (size_t i = 0; i < n; ++i, ++rec->line) {
+            fwrite(out + records[i].offset, 1, records[i].len, stdout);
+            putchar('\n');
+        }
+
+        in += consumed;
+        len -= consumed;
+    }
+
+    return 0;
+}
+
+// Read stdin & pass it on in batches of whole lines; a line is never split
+// across batches.
+static int records(encodefunc_t encode_func) {
+    size_t cap = 1 << 16, have = 0;
+    char *buf = malloc(cap);
+    struct records rec = { .encode_func = encode_func, .line = 1 };
+    int ret = 0;
+
+    if (!buf) {
+        perror("Out of memory");
+        return 1;
+    }
+
+    for (;;) {
+        if (have == cap) {
+            char *bigger = realloc(buf, cap * 2);
+            if (!bigger) {
+                perror("Out of memory");
+                ret = 1;
+                break;
+            }
+            buf = bigger;
+            cap *= 2;
+        }
+
+        ssize_t len = read(STDIN_FILENO, buf + have, cap - have);
+
+        if (len < 0) {
+            perror("Read error");
+            ret = 1;
+            break;
+        }
+
+        // Everything up to the last newline, or the rest at EOF
+        size_t batch = have += (size_t) len;
+        if (len > 0) {
+            while (batch > 0 && buf[batch - 1] != '\n')
+                --batch;
+        }
+
+        if (batch > 0) {
+            ret = encode_func ? encode_records(&rec, buf, batch)
+                              : decode_records(&rec, buf, batch);
+            if (ret)
+                break;
+            memmove(buf, buf + batch, have - batch);
+            have -= batch;
+        }
+
+        if (len == 0)
+            break;
+    }
+
+    free(buf);
+    free(rec.buf);
+
+    if (fflush(stdout) != 0) {
+        perror("Write error");
+        return 1;
+    }
+
+    return ret || rec.failed;
+}
+
 static void usage(const char *argv0, FILE *dest) {
     fprintf(dest, "Usage: %s [options]\n", argv0);
     fprintf(dest, "Options:\n"
-            "-h --help   Print this message\n"
-            "-d --decode Decode base64 or base64url input\n"
-            "-n --no-pad Elide padding when encoding\n"
-            "-u --url    Encode to base64url character set\n"
-            "            --base64url is an alias for this option\n"
+            "-h --help    Print this message\n"
+            "-d --decode  Decode base64 or base64url input\n"
+            "-n --no-pad  Elide padding when encoding\n"
+            "-r --records Encode or decode each line of input separately\n"
+            "-u --url     Encode to base64url character set\n"
+            "             --base64url is an alias for this option\n"
            );
 }
 
@@ -166,23 +316,28 @@ int main(int argc, char *argv[]) {
         { "decode",    no_argument, NULL, 'd' },
         { "help",      no_argument, NULL, 'h' },
         { "no-pad",    no_argument, NULL, 'n' },
+        { "records",   no_argument, NULL, 'r' },
         { "url",       no_argument, NULL, 'u' },
         { "base64url", no_argument, NULL, 'u' }, // alias for --url
     };
 
     int option;
-    bool url = false, nopad = false;
+    bool url = false, nopad = false, decode_mode = false, records_mode = false;
 
-    while ((option = getopt_long(argc, argv, "dhnu", options, NULL)) != -1) {
+    while ((option = getopt_long(argc, argv, "dhnru", options, NULL)) != -1) {
         switch (option) {
         case 'd':
-            return decode();
+            decode_mode = true;
+            break;
         case 'h':
             usage(argv[0], stdout);
             return 0;
         case 'n':
             nopad = true;
             break;
+        case 'r':
+            records_mode = true;
+            break;
         case 'u':
             url = true;
             break;
@@ -192,6 +347,9 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (decode_mode)
+        return records_mode ? records(NULL) : decode();
+
     encodefunc_t encode_func;
 
     if (url) {
@@ -206,5 +364,5 @@ int main(int argc, char *argv[]) {
             encode_func = fb64_encode;
     }
 
-    return encode(encode_func);
+    return records_mode ? records(encode_func) : encode(encode_func);
 }
@@ -70,6 +70,208 @@ size_t fb64_decoded_size_nopad(size_t inlen);
 FB64_EXPORT
 int fb64_decode(const char *in, size_t len, uint8_t *out);
 
+// Decode unpadded base64 string
+// For input that is never padded: '=' is an error. Faster than fb64_decode()
+// because the final block only needs special handling if it's partial.
+// Both alphabets are accepted, like fb64_decode().
+// Use fb64_decoded_size_nopad() to determine the output buffer size.
+FB64_EXPORT
+int fb64_decode_nopad(const char *in, size_t len, uint8_t *out);
+
+// Strict decoding:
+// Like fb64_decode() & fb64_decode_nopad(), but only accept symbols of one
+// alphabet: the standard base64 alphabet (+ & /) or base64url (- & _).
+// The padded versions require padding (ie. input length must be a multiple
+// of 4); the nopad versions reject it.
+// Returns nonzero on invalid input.
+FB64_EXPORT
+int fb64_decode_strict(const char *in, size_t len, uint8_t *out);
+
+FB64_EXPORT
+int fb64_decode_nopad_strict(const char *in, size_t len, uint8_t *out);
+
+FB64_EXPORT
+int fb64_decode_base64url_strict(const char *in, size_t len, uint8_t *out);
+
+FB64_EXPORT
+int fb64_decode_base64url_nopad_strict(const char *in, size_t len, uint8_t *out);
+
+// Decode base64 string without using lookup tables.
+// Same behaviour as fb64_decode(), but symbols are decoded arithmetically
+// rather than through the decode tables. Slower on hot loops, but avoids
+// the cache misses of pulling the tables in; useful for occasional decodes
+// of short inputs on latency-sensitive paths.
+FB64_EXPORT
+int fb64_decode_cold(const char *in, size_t len, uint8_t *out);
+
+// Decode base64 string using non-temporal stores.
+// Same behaviour as fb64_decode(), but output is written around the CPU
+// caches & input is prefetched without being kept in cache. Use for inputs
+// much larger than the last-level cache, whose output won't be read again
+// soon, to avoid evicting the working sets of other threads.
+// Where non-temporal stores are unavailable this is the same as fb64_decode().
+FB64_EXPORT
+int fb64_decode_nt(const char *in, size_t len, uint8_t *out);
+
+// Input size at which fb64_encode*() & fb64_decode() switch to non-temporal
+// stores on their own, as if the _nt() variant had been called. Outputs this
+// large don't fit in the last-level cache anyway, so writing them through
+// the cache only evicts other data. 16 MiB unless the library was built with
+// another FB64_NONTEMPORAL_THRESHOLD (SIZE_MAX if the switch is disabled).
+FB64_EXPORT
+__attribute__((__const__))
+size_t fb64_nontemporal_threshold(void);
+
+// Decode base64 string embedded in JSON
+// Accepts the raw contents of a JSON string, in which the encoder may have
+// escaped symbols as \/ or \u00XX (eg. \u002B for '+'). Escapes are decoded
+// in the same pass as the base64; input without backslashes is decoded as
+// fast as fb64_decode().
+// Returns nonzero on invalid input, including any escape that doesn't stand
+// for an ASCII character.
+// The decoded length is stored in *outlen. Escaping makes the input longer,
+// so fb64_decoded_size() of the escaped input is enough output buffer space.
+FB64_EXPORT
+int fb64_decode_json(const char *in, size_t len, uint8_t *out, size_t *outlen);
+
+// Compare base64 input with the bytes it should decode to, eg. to verify an
+// API key or MAC. Decodes & compares block by block without writing the
+// decoded bytes anywhere. Takes the same time for any input & expected bytes
+// of the same lengths (ie. it doesn't stop at the first difference, & doesn't
+// use lookup tables).
+// Accepts the same input as fb64_decode().
+// Like memcmp(), returns 0 if the input is valid & decodes to exactly
+// `expected`; nonzero if it's invalid or decodes to anything else.
+FB64_EXPORT
+int fb64_decode_equals(const char *in, size_t len, const uint8_t *expected, size_t expected_len);
+
+// Delimited records:
+// fb64_decode_records() decodes a buffer of base64 records separated by
+// `delim` (eg. one record per line) in a single pass, as fb64_decode() would
+// decode each record. Decoded records are written back to back to `out` &
+// described by one fb64_record each. A delimiter at the very end of the
+// input doesn't start another record. When `delim` is '\n' a '\r' before it
+// is ignored too.
+// fb64_encode_records() is the reverse: it encodes each delimited record of
+// raw bytes & describes the encoded records the same way.
+struct fb64_record {
+    size_t offset; // of the record in the output buffer
+    size_t len;    // its length; 0 if the record is invalid
+    int err;       // nonzero if the record is invalid (never when encoding)
+};
+
+// Decode delimited records
+// Stops after max_records records. Returns the number of records stored in
+// `records` & sets *consumed (unless NULL) to the amount of input used, so
+// that the rest can be decoded by another call.
+// Output needs at most fb64_decoded_size_nopad(len) bytes. Invalid records
+// don't use any output, but may have scribbled over the space after the
+// preceding record.
+FB64_EXPORT
+size_t fb64_decode_records(const char *in, size_t len, char delim, uint8_t *out,
+        struct fb64_record *records, size_t max_records, size_t *consumed);
+
+// Alphabet & padding flags for fb64_encode_records(); 0 is padded base64 as
+// from fb64_encode().
+#define FB64_RECORD_URL   (1u << 0) // base64url, as fb64_encode_base64url()
+#define FB64_RECORD_NOPAD (1u << 1) // without padding, as fb64_encode_nopad()
+
+// Encode delimited records
+// Stops after max_records records, like fb64_decode_records(). Delimiters
+// aren't copied to the output; use the records' offsets & lengths to put the
+// encoded records back together with whatever separators are needed.
+// Output needs at most len * 2 + 2 bytes (for records of 1 byte each).
+FB64_EXPORT
+size_t fb64_encode_records(const uint8_t *in, size_t len, char delim, unsigned flags,
+        char *out, struct fb64_record *records, size_t max_records, size_t *consumed);
+
+// Decode into a buffer of limited size, eg. a socket send window
+// Decodes as much of the input as fits in `outcap` bytes of output: all of
+// it, or as many whole blocks (3 output bytes each) as fit. Sets *consumed
+// & *produced to the amount of input decoded & output written, so that the
+// next call can resume from in + *consumed. Input is done when *consumed ==
+// len. Any outcap of at least 3 makes progress.
+// Accepts the same input as fb64_decode(). Returns nonzero on invalid input,
+// setting *consumed & *produced to 0; output may have been written anyway.
+FB64_EXPORT
+int fb64_decode_partial(const char *in, size_t len, uint8_t *out, size_t outcap,
+        size_t *consumed, size_t *produced);
+
+// Classification:
+// fb64_classify() scans input once & reports which variant of base64 it is,
+// so that it can be routed to the appropriate (possibly strict) decoder.
+// The result is a combination of these flags; 0 means the input is valid
+// for either alphabet & needs no padding (or is empty).
+
+// Contains '+' or '/' (standard base64 alphabet)
+#define FB64_CLASS_STANDARD   (1u << 0)
+// Contains '-' or '_' (base64url alphabet)
+// If both STANDARD & URL are set the input mixes alphabets.
+#define FB64_CLASS_URL        (1u << 1)
+// Ends with '=' padding
+#define FB64_CLASS_PADDED     (1u << 2)
+// Length isn't a multiple of 4 & there's no padding:
+// only valid for decoders that accept unpadded input.
+#define FB64_CLASS_UNPADDED   (1u << 3)
+// Contains a character in neither alphabet, or '=' other than as padding
+#define FB64_CLASS_BAD_SYMBOL (1u << 4)
+// Length can't be valid base64, with or without padding. This includes
+// partial padding (eg. "Zg="): the strict decoders reject it, but
+// fb64_decode() accepts it, so lenient callers may still decode such input.
+#define FB64_CLASS_BAD_LENGTH (1u << 5)
+
+#define FB64_CLASS_INVALID (FB64_CLASS_BAD_SYMBOL | FB64_CLASS_BAD_LENGTH)
+
+// Classify base64 input
+// Returns a combination of the FB64_CLASS_ flags above.
+FB64_EXPORT
+__attribute__((__pure__))
+unsigned fb64_classify(const char *in, size_t len);
+
+// Decode the base64 encoding of exactly 16, 32 or 64 bytes
+// eg. UUIDs, 256-bit keys & hashes, 512-bit signatures.
+// Input may be padded or unpadded (ie. 22 or 24 chars for 16 bytes; 43 or 44
+// for 32 bytes; 86 or 88 for 64 bytes) & either alphabet; any other length is
+// invalid. These compile to straight-line code without the loop & tail
+// handling of fb64_decode().
+// Returns nonzero on invalid input.
+FB64_EXPORT
+int fb64_decode_16(const char *in, size_t len, uint8_t out[16]);
+
+FB64_EXPORT
+int fb64_decode_32(const char *in, size_t len, uint8_t out[32]);
+
+FB64_EXPORT
+int fb64_decode_64(const char *in, size_t len, uint8_t out[64]);
+
+// Integer IDs:
+// 64 & 128-bit integers as fixed-length, unpadded base64url: the same as
+// fb64_encode_base64url_nopad() of the integer's big-endian bytes. 128-bit
+// integers are passed as their high & low halves.
+#define FB64_U64_LEN  11
+#define FB64_U128_LEN 22
+
+FB64_EXPORT void fb64_encode_u64(uint64_t id, char out[FB64_U64_LEN]);
+FB64_EXPORT void fb64_encode_u128(uint64_t hi, uint64_t lo, char out[FB64_U128_LEN]);
+
+// Parse an ID encoded by the functions above.
+// Returns nonzero unless the input is exactly FB64_U64_LEN or FB64_U128_LEN
+// base64url symbols & is the canonical encoding (the unused low bits of the
+// final symbol are 0).
+FB64_EXPORT int fb64_decode_u64(const char *in, size_t len, uint64_t *id);
+FB64_EXPORT int fb64_decode_u128(const char *in, size_t len, uint64_t *hi, uint64_t *lo);
+
+// Encode or parse `n` IDs at once, vectorized where the CPU supports it.
+// Encoded IDs are back to back with no separator: n * FB64_U64_LEN or
+// n * FB64_U128_LEN chars. 128-bit IDs are pairs of high & low halves in
+// `ids`, so it holds n * 2 values.
+// The decoders return nonzero if any of the IDs is invalid; the values
+// written for invalid IDs are unspecified.
+FB64_EXPORT void fb64_encode_u64_batch(const uint64_t *ids, size_t n, char *out);
+FB64_EXPORT void fb64_encode_u128_batch(const uint64_t *ids, size_t n, char *out);
+FB64_EXPORT int fb64_decode_u64_batch(const char *in, size_t n, uint64_t *ids);
+FB64_EXPORT int fb64_decode_u128_batch(const char *in, size_t n, uint64_t *ids);
+
 // Encoding:
 // These functions *do not* output a trailing NUL-byte. Neither the encoding
 // functions nor the fb64_encoded_size*() functions include space for
@@ -108,6 +310,109 @@ void fb64_encode_base64url(const uint8_t *buf, size_t len, char *out);
 FB64_EXPORT
 void fb64_encode_base64url_nopad(const uint8_t *buf, size_t len, char *out);
 
+// Encode exactly 16, 32 or 64 bytes to Base64
+// Same output as the corresponding functions above with len set to 16, 32 or
+// 64, but compiled to straight-line code without the loop & tail handling.
+// Output is fb64_encoded_size(n) or fb64_encoded_size_nopad(n) chars.
+FB64_EXPORT void fb64_encode_16(const uint8_t buf[16], char *out);
+FB64_EXPORT void fb64_encode_nopad_16(const uint8_t buf[16], char *out);
+FB64_EXPORT void fb64_encode_base64url_16(const uint8_t buf[16], char *out);
+FB64_EXPORT void fb64_encode_base64url_nopad_16(const uint8_t buf[16], char *out);
+
+FB64_EXPORT void fb64_encode_32(const uint8_t buf[32], char *out);
+FB64_EXPORT void fb64_encode_nopad_32(const uint8_t buf[32], char *out);
+FB64_EXPORT void fb64_encode_base64url_32(const uint8_t buf[32], char *out);
+FB64_EXPORT void fb64_encode_base64url_nopad_32(const uint8_t buf[32], char *out);
+
+FB64_EXPORT void fb64_encode_64(const uint8_t buf[64], char *out);
+FB64_EXPORT void fb64_encode_nopad_64(const uint8_t buf[64], char *out);
+FB64_EXPORT void fb64_encode_base64url_64(const uint8_t buf[64], char *out);
+FB64_EXPORT void fb64_encode_base64url_nopad_64(const uint8_t buf[64], char *out);
+
+// Encode bytes to Base64 using non-temporal stores.
+// Same output as the corresponding functions above, but written around the
+// CPU caches; see fb64_decode_nt().
+// Non-temporal stores are only used if `out` is 4-byte aligned.
+FB64_EXPORT
+void fb64_encode_nt(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_encode_nopad_nt(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_encode_base64url_nt(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_encode_base64url_nopad_nt(const uint8_t *buf, size_t len, char *out);
+
+// Base16 (hex) & base32 (RFC 4648 sections 6-8)
+// Same conventions as base64: exact size functions, no NUL terminator,
+// decoders return nonzero on invalid input. Decoders accept either case.
+
+// Size of output buffer needed to encode/decode base16
+FB64_EXPORT
+__attribute__((__const__))
+size_t fb64_base16_encoded_size(size_t input_len);
+
+FB64_EXPORT
+__attribute__((__const__))
+size_t fb64_base16_decoded_size(size_t inlen);
+
+// Encode bytes to base16, with uppercase (RFC 4648) or lowercase letters
+FB64_EXPORT
+void fb64_base16_encode(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_base16_encode_lower(const uint8_t *buf, size_t len, char *out);
+
+// Decode base16
+// Returns nonzero on invalid input, including an odd length.
+FB64_EXPORT
+int fb64_base16_decode(const char *in, size_t len, uint8_t *out);
+
+// Size of output buffer needed to encode base32 or base32hex input with
+// padding (a multiple of 8) or without.
+FB64_EXPORT
+__attribute__((__const__))
+size_t fb64_base32_encoded_size(size_t input_len);
+
+FB64_EXPORT
+__attribute__((__const__))
+size_t fb64_base32_encoded_size_nopad(size_t input_len);
+
+// Determine length for base32 or base32hex input with padding (possible
+// trailing '='s) or without.
+FB64_EXPORT
+__attribute__((__pure__))
+size_t fb64_base32_decoded_size(const char *input, size_t inlen);
+
+FB64_EXPORT
+__attribute__((__const__))
+size_t fb64_base32_decoded_size_nopad(size_t inlen);
+
+// Encode bytes to base32 (A-Z, 2-7) or base32hex (0-9, A-V), with or
+// without padding.
+FB64_EXPORT
+void fb64_base32_encode(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_base32_encode_nopad(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_base32hex_encode(const uint8_t *buf, size_t len, char *out);
+
+FB64_EXPORT
+void fb64_base32hex_encode_nopad(const uint8_t *buf, size_t len, char *out);
+
+// Decode base32 or base32hex, padded or not
+// Padding, if present, must complete the final group of 8 symbols.
+// Returns nonzero on invalid input.
+FB64_EXPORT
+int fb64_base32_decode(const char *in, size_t len, uint8_t *out);
+
+FB64_EXPORT
+int fb64_base32hex_decode(const char *in, size_t len, uint8_t *out);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,586 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FB64_HPP
+#define FB64_HPP 1
+
+// C++ interface to fb64.
+//
+// fb64::encode() & fb64::decode() are constexpr & header-only, following the
+// same alphabet & padding rules as fb64_encode() & fb64_decode(): decoding
+// accepts base64 & base64url symbols (even mixed) with or without padding.
+// Use them to encode or decode constants at compile time; an invalid
+// constant fails to compile.
+//
+// For runtime data, fb64::codec selects the C kernel specialized for an
+// alphabet, padding & strictness combination at compile time.
+// fb64::stream_encoder & fb64::stream_decoder encode/decode input that
+// arrives in chunks, & (C++20) fb64::views::encode & fb64::views::decode
+// are lazy range adaptors built on them.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#if __cplusplus >= 202002L
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#endif
+
+#include "fb64.h"
+
+namespace fb64 {
+
+enum class alphabet {
+    base64,    // + & /
+    base64url, // - & _
+};
+
+enum class padding {
+    pad,   // encode: add padding; decode: accept padding
+    nopad, // encode: omit padding; decode: reject padding
+};
+
+enum class strictness {
+    lenient, // decode: accept symbols of both alphabets
+    strict,  // decode: accept only the selected alphabet; padding required if padding::pad
+};
+
+namespace detail {
+
+inline constexpr std::string_view b64 =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+inline constexpr std::string_view b64url =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Value of a base64 or base64url symbol, or -1 if it's neither.
+constexpr int sextet(char c) {
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+' || c == '-')
+        return 62;
+    if (c == '/' || c == '_')
+        return 63;
+    return -1;
+}
+
+} // namespace detail
+
+// Same as fb64_encoded_size() & fb64_encoded_size_nopad()
+constexpr std::size_t encoded_size(std::size_t input_len, padding p = padding::pad) {
+    return p == padding::pad ? (input_len + 2) / 3 * 4 : (input_len * 4 + 2) / 3;
+}
+
+// Same as fb64_decoded_size()
+constexpr std::size_t decoded_size(std::string_view in) {
+    std::size_t len = in.size();
+
+    if (len >= 1 && in[len - 1] == '=') {
+        if (len >= 2 && in[len - 2] == '=')
+            len -= 2;
+        else
+            len -= 1;
+    }
+
+    return len * 3 / 4;
+}
+
+// Encode into an array of exactly the encoded size (no NUL terminator).
+template <alphabet A = alphabet::base64, padding P = padding::pad, std::size_t N>
+constexpr std::array<char, encoded_size(N, P)> encode(const std::array<std::uint8_t, N>& in) {
+    constexpr std::string_view table = A == alphabet::base64 ? detail::b64 : detail::b64url;
+    std::array<char, encoded_size(N, P)> out{};
+    std::size_t o = 0;
+
+    for (std::size_t i = 0; i < N; i += 3) {
+        const unsigned b0 = in[i];
+        const unsigned b1 = i + 1 < N ? in[i + 1] : 0;
+        const unsigned b2 = i + 2 < N ? in[i + 2] : 0;
+
+        out[o++] = table[b0 >> 2];
+        out[o++] = table[(b0 & 3) << 4 | b1 >> 4];
+
+        if (i + 1 < N)
+            out[o++] = table[(b1 & 15) << 2 | b2 >> 6];
+        else if (P == padding::pad)
+            out[o++] = '=';
+
+        if (i + 2 < N)
+            out[o++] = table[b2 & 63];
+        else if (P == padding::pad)
+            out[o++] = '=';
+    }
+
+    return out;
+}
+
+// Encode the characters of a string literal (without its NUL terminator).
+template <alphabet A = alphabet::base64, padding P = padding::pad, std::size_t N>
+constexpr std::array<char, encoded_size(N - 1, P)> encode(const char (&in)[N]) {
+    std::array<std::uint8_t, N - 1> bytes{};
+    for (std::size_t i = 0; i < N - 1; ++i)
+        bytes[i] = static_cast<std::uint8_t>(in[i]);
+    return encode<A, P>(bytes);
+}
+
+// Decode into an array of Size bytes, which must be decoded_size(in).
+// Throws std::invalid_argument on invalid input, exactly where fb64_decode()
+// would fail, or if the decoded size doesn't match. In a constant expression
+// that's a compile error.
+template <std::size_t Size>
+constexpr std::array<std::uint8_t, Size> decode(std::string_view in) {
+    if (decoded_size(in) != Size)
+        throw std::invalid_argument("fb64: decoded size mismatch");
+
+    std::size_t len = in.size();
+
+    // Same padding rules as fb64_decode(): padding is only stripped from
+    // the final block.
+    if (len % 4 == 0 && len >= 4 && in[len - 1] == '=')
+        --len;
+    if (len % 4 == 3 && in[len - 1] == '=')
+        --len;
+    if (len % 4 == 1 || (len % 4 == 2 && in[len - 1] == '='))
+        throw std::invalid_argument("fb64: truncated input");
+
+    std::array<std::uint8_t, Size> out{};
+    std::size_t o = 0;
+
+    for (std::size_t i = 0; i < len; i += 4) {
+        int s[4] = {0, 0, 0, 0};
+
+        for (std::size_t j = 0; j < 4 && i + j < len; ++j) {
+            s[j] = detail::sextet(in[i + j]);
+            if (s[j] < 0)
+                throw std::invalid_argument("fb64: invalid symbol");
+        }
+
+        const std::uint8_t bytes[3] = {
+            static_cast<std::uint8_t>(s[0] << 2 | s[1] >> 4),
+            static_cast<std::uint8_t>(s[1] << 4 | s[2] >> 2),
+            static_cast<std::uint8_t>(s[2] << 6 | s[3]),
+        };
+
+        for (std::size_t j = 0; j < 3 && o < Size; ++j)
+            out[o++] = bytes[j];
+    }
+
+    return out;
+}
+
+// Runtime encode & decode for one combination of alphabet, padding &
+// strictness. Each combination maps onto its own specialized C function,
+// which is compiled from the shared kernel with that combination's dead
+// branches removed: eg. codec<alphabet::base64url, padding::nopad> decodes
+// with fb64_decode_nopad(), which skips the padding handling & final block
+// copy of fb64_decode().
+// Strictness only affects decoding, & the alphabet only affects decoding
+// when strict.
+template <alphabet A = alphabet::base64, padding P = padding::pad,
+          strictness S = strictness::lenient>
+struct codec {
+    static constexpr std::size_t encoded_size(std::size_t input_len) {
+        return fb64::encoded_size(input_len, P);
+    }
+
+    static std::size_t decoded_size(const char *in, std::size_t len) {
+        if constexpr (P == padding::pad)
+            return fb64_decoded_size(in, len);
+        else
+            return fb64_decoded_size_nopad(len);
+    }
+
+    static void encode(const std::uint8_t *buf, std::size_t len, char *out) {
+        if constexpr (A == alphabet::base64 && P == padding::pad)
+            fb64_encode(buf, len, out);
+        else if constexpr (A == alphabet::base64)
+            fb64_encode_nopad(buf, len, out);
+        else if constexpr (P == padding::pad)
+            fb64_encode_base64url(buf, len, out);
+        else
+            fb64_encode_base64url_nopad(buf, len, out);
+    }
+
+    // Returns nonzero on invalid input.
+    static int decode(const char *in, std::size_t len, std::uint8_t *out) {
+        if constexpr (S == strictness::lenient && P == padding::pad)
+            return fb64_decode(in, len, out);
+        else if constexpr (S == strictness::lenient)
+            return fb64_decode_nopad(in, len, out);
+        else if constexpr (A == alphabet::base64 && P == padding::pad)
+            return fb64_decode_strict(in, len, out);
+        else if constexpr (A == alphabet::base64)
+            return fb64_decode_nopad_strict(in, len, out);
+        else if constexpr (P == padding::pad)
+            return fb64_decode_base64url_strict(in, len, out);
+        else
+            return fb64_decode_base64url_nopad_strict(in, len, out);
+    }
+};
+
+// Incremental encoder for input that arrives in chunks, eg. from a socket or
+// between co_awaits in a coroutine. Chunks may be any length: whole blocks
+// are encoded immediately & up to 2 leftover bytes are carried over to the
+// next call. Memory use is constant regardless of the total input size.
+template <alphabet A = alphabet::base64, padding P = padding::pad>
+class stream_encoder {
+public:
+    // Most output that update() can produce from `len` bytes of input.
+    static constexpr std::size_t max_output(std::size_t len) {
+        return (len + 2) / 3 * 4;
+    }
+
+    // Encodes as much of the carried-over & new input as forms whole blocks.
+    // Returns the number of chars written to `out`.
+    std::size_t update(const std::uint8_t *buf, std::size_t len, char *out) {
+        std::size_t written = 0;
+
+        if (carry_len_ > 0) {
+            while (carry_len_ < 3 && len > 0) {
+                carry_[carry_len_++] = *buf++;
+                --len;
+            }
+
+            if (carry_len_ < 3)
+                return 0;
+
+            codec<A, P>::encode(carry_, 3, out);
+            written = 4;
+            carry_len_ = 0;
+        }
+
+        const std::size_t whole = len / 3 * 3;
+        codec<A, P>::encode(buf, whole, out + written);
+        written += whole / 3 * 4;
+
+        carry_len_ = len - whole;
+        std::memcpy(carry_, buf + whole, carry_len_);
+
+        return written;
+    }
+
+    // Encodes the carried-over bytes, with padding if P is padding::pad.
+    // Returns the number of chars written to `out` (at most 4).
+    std::size_t finish(char *out) {
+        codec<A, P>::encode(carry_, carry_len_, out);
+        const std::size_t written = codec<A, P>::encoded_size(carry_len_);
+        carry_len_ = 0;
+        return written;
+    }
+
+private:
+    std::uint8_t carry_[3] = {};
+    std::size_t carry_len_ = 0;
+};
+
+// Incremental decoder for input that arrives in chunks. Chunks may be any
+// length. Since only the final block may be padded, the last whole block
+// seen is held back (with any partial block) until more input arrives or
+// finish() is called.
+// Once invalid input is seen, failed() is true & further output is garbage.
+template <alphabet A = alphabet::base64, padding P = padding::pad,
+          strictness S = strictness::lenient>
+class stream_decoder {
+public:
+    // Most output that update() can produce from `len` bytes of input.
+    static constexpr std::size_t max_output(std::size_t len) {
+        return (len + 4) / 4 * 3;
+    }
+
+    // Decodes the whole blocks of held-back & new input except the last one.
+    // Returns the number of bytes written to `out`.
+    std::size_t update(const char *in, std::size_t len, std::uint8_t *out) {
+        // Blocks that aren't last can't be padded.
+        using body = codec<A, padding::nopad, S>;
+        std::size_t written = 0;
+
+        if (held_len_ + len <= 4) {
+            std::memcpy(held_ + held_len_, in, len);
+            held_len_ += len;
+            return 0;
+        }
+
+        if (held_len_ > 0) {
+            const std::size_t take = 4 - held_len_;
+            std::memcpy(held_ + held_len_, in, take);
+            in += take;
+            len -= take;
+
+            bad_ |= body::decode(held_, 4, out);
+            written = 3;
+        }
+
+        // len > 0 here, so keep back 1-4 chars
+        const std::size_t keep = (len - 1) % 4 + 1;
+        bad_ |= len > keep && body::decode(in, len - keep, out + written);
+        written += (len - keep) / 4 * 3;
+
+        std::memcpy(held_, in + len - keep, keep);
+        held_len_ = keep;
+
+        return written;
+    }
+
+    // Decodes the held-back input, which may be padded if P is padding::pad.
+    // Returns the number of bytes written to `out` (at most 3).
+    std::size_t finish(std::uint8_t *out) {
+        std::size_t written = 0;
+
+        if (held_len_ > 0) {
+            bad_ |= codec<A, P, S>::decode(held_, held_len_, out) != 0;
+            written = codec<A, P, S>::decoded_size(held_, held_len_);
+        }
+
+        held_len_ = 0;
+        return written;
+    }
+
+    bool failed() const {
+        return bad_;
+    }
+
+private:
+    char held_[4] = {};
+    std::size_t held_len_ = 0;
+    bool bad_ = false;
+};
+
+#if __cplusplus >= 202002L
+namespace views {
+
+// Amount of input the views encode/decode at a time.
+inline constexpr std::size_t block_size = 3 * 1024;
+
+namespace detail {
+
+// Fills buf with up to `size` elements from [it, end). Contiguous ranges of
+// bytes or chars are copied in one go.
+template <typename V, typename T>
+std::size_t read_block(V& base, std::ranges::iterator_t<V>& it, T *buf, std::size_t size) {
+    const auto end = std::ranges::end(base);
+    std::size_t n = 0;
+
+    if constexpr (std::ranges::contiguous_range<V> && std::ranges::sized_range<V> &&
+            sizeof(std::ranges::range_value_t<V>) == 1) {
+        n = std::min<std::size_t>(size, static_cast<std::size_t>(end - it));
+        std::memcpy(buf, std::to_address(it), n);
+        it += static_cast<std::ranges::range_difference_t<V>>(n);
+    } else {
+        for (; n < size && it != end; ++it)
+            buf[n++] = static_cast<T>(*it);
+    }
+
+    return n;
+}
+
+// Input view over the output of a stream codec, refilled a block at a time.
+// The view owns the block buffers, so it can only be iterated once.
+template <typename V, typename Codec, typename In, typename Out, std::size_t InSize, std::size_t OutSize>
+class codec_view : public std::ranges::view_interface<codec_view<V, Codec, In, Out, InSize, OutSize>> {
+public:
+    class iterator {
+    public:
+        using value_type = Out;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(codec_view *parent) : parent_(parent) {}
+
+        Out operator*() const {
+            return parent_->out_[parent_->pos_];
+        }
+
+        iterator& operator++() {
+            if (++parent_->pos_ == parent_->len_)
+                parent_->fill();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) {
+            return it.at_end();
+        }
+
+    private:
+        bool at_end() const {
+            return parent_->pos_ == parent_->len_;
+        }
+
+        codec_view *parent_ = nullptr;
+    };
+
+    codec_view() requires std::default_initializable<V> = default;
+    explicit codec_view(V base) : base_(std::move(base)) {}
+
+    iterator begin() {
+        it_.emplace(std::ranges::begin(base_));
+        fill();
+        return iterator(this);
+    }
+
+    std::default_sentinel_t end() const {
+        return {};
+    }
+
+private:
+    // Produces the next non-empty block of output, or none at the end.
+    void fill() {
+        pos_ = len_ = 0;
+
+        while (len_ == 0 && !done_) {
+            const std::size_t n = read_block(base_, *it_, in_.data(), InSize);
+            len_ = codec_.update(in_.data(), n, out_.data());
+
+            if (n < InSize) {
+                len_ += codec_.finish(out_.data() + len_);
+                done_ = true;
+            }
+
+            check();
+        }
+    }
+
+    void check() {
+        if constexpr (requires { codec_.failed(); }) {
+            if (codec_.failed())
+                throw std::invalid_argument("fb64: invalid input");
+        }
+    }
+
+    V base_;
+    std::optional<std::ranges::iterator_t<V>> it_;
+    Codec codec_;
+    std::array<In, InSize> in_{};
+    std::array<Out, OutSize> out_{};
+    std::size_t pos_ = 0, len_ = 0;
+    bool done_ = false;
+};
+
+template <template <typename> typename View>
+struct adaptor {
+    template <std::ranges::viewable_range R>
+    auto operator()(R&& r) const {
+        return View<std::views::all_t<R>>(std::views::all(std::forward<R>(r)));
+    }
+
+    template <std::ranges::viewable_range R>
+    friend auto operator|(R&& r, const adaptor& a) {
+        return a(std::forward<R>(r));
+    }
+};
+
+template <alphabet A, padding P>
+struct encoder {
+    using codec = stream_encoder<A, P>;
+
+    template <typename V>
+    using view = codec_view<V, codec, std::uint8_t, char,
+          block_size, codec::max_output(block_size) + 4>;
+};
+
+template <alphabet A, padding P, strictness S>
+struct decoder {
+    using codec = stream_decoder<A, P, S>;
+
+    template <typename V>
+    using view = codec_view<V, codec, char, std::uint8_t,
+          block_size, codec::max_output(block_size) + 3>;
+};
+
+} // namespace detail
+
+// Lazy base64 encoding of a range of bytes (or chars), as a single-pass
+// range of chars:
+//
+//     for (char c: bytes | fb64::views::encode) ...
+//
+// Input is read & encoded block_size bytes at a time, so memory use is
+// bounded no matter how long the input is.
+template <alphabet A = alphabet::base64, padding P = padding::pad>
+inline constexpr detail::adaptor<detail::encoder<A, P>::template view> encode_with{};
+
+inline constexpr auto encode = encode_with<>;
+
+// Lazy base64 decoding of a range of chars, as a single-pass range of bytes:
+//
+//     for (std::uint8_t b: std::views::istream<char>(in) | fb64::views::decode) ...
+//
+// Input is read & decoded block_size chars at a time. Iterating throws
+// std::invalid_argument when invalid input is reached.
+template <alphabet A = alphabet::base64, padding P = padding::pad,
+          strictness S = strictness::lenient>
+inline constexpr detail::adaptor<detail::decoder<A, P, S>::template view> decode_with{};
+
+inline constexpr auto decode = decode_with<>;
+
+} // namespace views
+
+// Compile-time literals (C++20):
+//
+//     using namespace fb64::literals;
+//     constexpr auto key = "Zm9vYmFy"_fb64; // std::array<uint8_t, 6>
+//
+// Invalid literals fail to compile.
+
+template <std::size_t N>
+struct fixed_string {
+    char data[N] = {};
+
+    constexpr fixed_string(const char (&s)[N]) {
+        for (std::size_t i = 0; i < N; ++i)
+            data[i] = s[i];
+    }
+
+    constexpr std::string_view view() const {
+        return std::string_view(data, N - 1);
+    }
+};
+
+namespace literals {
+
+template <fixed_string S>
+consteval auto operator""_fb64() {
+    return decode<decoded_size(S.view())>(S.view());
+}
+
+} // namespace literals
+#endif
+
+} // namespace fb64
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Internal settings for the non-temporal (cache-bypassing) encode & decode
+// paths, shared by encode.c & decode.c. Not installed.
+
+#ifndef FB64_NONTEMPORAL_H
+#define FB64_NONTEMPORAL_H 1
+
+// Inputs of at least this many bytes are encoded/decoded with non-temporal
+// stores by fb64_encode*() & fb64_decode(), as if the _nt() variant had been
+// called. This is a library build-time setting; define it as SIZE_MAX when
+// building the library to disable the automatic switch. Clients can read
+// the value the library was built with from fb64_nontemporal_threshold().
+#ifndef FB64_NONTEMPORAL_THRESHOLD
+#define FB64_NONTEMPORAL_THRESHOLD (16 * 1024 * 1024)
+#endif
+
+// How far ahead of the encode/decode position to prefetch input in
+// non-temporal mode.
+#define NT_PREFETCH_DISTANCE 1024
+
+#endif // FB64_NONTEMPORAL_H
@@ -78,35 +78,829 @@ static const struct {
     { "\xff\xff\xfe", 3, "___-", true, true },
 };
 
+static const struct {
+    // JSON string contents & the same base64 without escapes
+    const char *json, *unescaped;
+    bool error:1;
+} json_tests[] = {
+    { "", "" },
+    { "Zm9vYmFy", "Zm9vYmFy" },
+    { "\\/\\/\\/\\/", "////" },
+    { "Zm9\\/Zm9v", "Zm9/Zm9v" },
+    { "Zm9vYmFy\\/\\/\\/", "Zm9vYmFy///" },
+    { "SGVsbG8sIHdvcmxkIQ\\u003d\\u003D", "SGVsbG8sIHdvcmxkIQ==" },
+    { "\\u002b\\u002B++Zg==", "++++Zg==" },
+    { "Zm\\u00389v", "Zm89v", true },
+    { "Zm\\u003d9v", "", true },
+    { "Zm9v\\n", "", true },
+    { "Zm9v\\\\", "", true },
+    { "Zm9v\\u00e9", "", true },
+    { "Zm9v\\u002", "", true },
+    { "Zm9v\\", "", true },
+};
+
+static const struct {
+    const char *encoded, *expected;
+    bool equal;
+} equals_tests[] = {
+    { "", "", true },
+    { "Zg==", "f", true },
+    { "Zg", "f", true },
+    { "Zg=", "f", true },
+    { "Zm9vYmFy", "foobar", true },
+    { "SGVsbG8sIHdvcmxkIQ==", "Hello, world!", true },
+    { "SGVsbG8sIHdvcmxkIQ", "Hello, world!", true },
+    { "SGVsbG8sIHdvcmxkIQ==", "Hello, world?", false },
+    { "SGVsbG8sIHdvcmxkIQ==", "Jello, world!", false },
+    { "SGVsbG8sIHdvcmxkIQ==", "Hello, world", false },
+    { "SGVsbG8sIHdvcmxkIQ==", "Hello, world!!", false },
+    { "Zm9vYmFy", "fooba", false },
+    { "Zm9vYmF", "fooba", true },
+    { "Zm9v!mFy", "foobar", false },
+    { "Zm9=YmFy", "foobar", false },
+    { "Zm9vY", "foo", false },
+    { "Zm9vY", "foob", false },
+    { "", "f", false },
+};
+
+static const struct {
+    const char *input;
+    unsigned expect;
+} classify_tests[] = {
+    { "", 0 },
+    { "Zm9vYmFy", 0 },
+    { "Zg==", FB64_CLASS_PADDED },
+    { "Zm8=", FB64_CLASS_PADDED },
+    { "Zg", FB64_CLASS_UNPADDED },
+    { "Zm8", FB64_CLASS_UNPADDED },
+    { "Z", FB64_CLASS_BAD_LENGTH },
+    { "Zg=", FB64_CLASS_PADDED | FB64_CLASS_BAD_LENGTH },
+    { "Z===", FB64_CLASS_PADDED | FB64_CLASS_BAD_SYMBOL },
+    { "Zm9vYmFyZm9vYmFy////", FB64_CLASS_STANDARD },
+    { "Zm9vYmFyZm9vYmFy+AAA", FB64_CLASS_STANDARD },
+    { "Zm9vYmFyZm9vYmFy____", FB64_CLASS_URL },
+    { "Zm9vYmFy-m9vYmFyZm9v", FB64_CLASS_URL },
+    { "Zm9vYmFy-m9vYmFyZm9/", FB64_CLASS_STANDARD | FB64_CLASS_URL },
+    { "SGVsbG8sIHdvcmxkIQ==", FB64_CLASS_PADDED },
+    { "SGVsbG8sIHdvcmxkIQ", FB64_CLASS_UNPADDED },
+    { "SGVsbG8sIHdvcmxk IQ==", FB64_CLASS_PADDED | FB64_CLASS_BAD_LENGTH | FB64_CLASS_BAD_SYMBOL },
+    { "SGVsbG8sIHdvcmx=IQ==", FB64_CLASS_PADDED | FB64_CLASS_BAD_SYMBOL },
+    { "SGVsbG8sIHdvcmxkIQ\n", FB64_CLASS_UNPADDED | FB64_CLASS_BAD_SYMBOL },
+    { "#!/bin/bash", FB64_CLASS_STANDARD | FB64_CLASS_UNPADDED | FB64_CLASS_BAD_SYMBOL },
+};
+
+// Decoders with padding & alphabet policies
+static const struct {
+    const char *name;
+    int (*decode)(const char*, size_t, uint8_t*);
+} policy_decoders[] = {
+    { "fb64_decode", fb64_decode },
+    { "fb64_decode_nopad", fb64_decode_nopad },
+    { "fb64_decode_strict", fb64_decode_strict },
+    { "fb64_decode_nopad_strict", fb64_decode_nopad_strict },
+    { "fb64_decode_base64url_strict", fb64_decode_base64url_strict },
+    { "fb64_decode_base64url_nopad_strict", fb64_decode_base64url_nopad_strict },
+};
+
+// Bits of policy_decoders that accept each input
+#define LENIENT   (1 << 0)
+#define NOPAD     (1 << 1)
+#define STRICT    (1 << 2)
+#define NOPAD_STRICT (1 << 3)
+#define URL_STRICT   (1 << 4)
+#define URL_NOPAD_STRICT (1 << 5)
+#define ALL 0x3f
+
+static const struct {
+    const char *encoded;
+    unsigned accepted;
+} policy_tests[] = {
+    { "", ALL },
+    { "Zm9v", ALL },
+    { "Zm9vYmFy", ALL },
+    { "Zg==", LENIENT | STRICT | URL_STRICT },
+    { "Zm9vYg==", LENIENT | STRICT | URL_STRICT },
+    { "Zg", LENIENT | NOPAD | NOPAD_STRICT | URL_NOPAD_STRICT },
+    { "Zm9vYmE", LENIENT | NOPAD | NOPAD_STRICT | URL_NOPAD_STRICT },
+    { "Zg=", LENIENT },
+    { "++//", LENIENT | NOPAD | STRICT | NOPAD_STRICT },
+    { "Zm9v+w", LENIENT | NOPAD | NOPAD_STRICT },
+    { "--__", LENIENT | NOPAD | URL_STRICT | URL_NOPAD_STRICT },
+    { "Zm9v_w==", LENIENT | URL_STRICT },
+    { "-AAAZm9v", LENIENT | NOPAD | URL_STRICT | URL_NOPAD_STRICT },
+    { "/AAAZm9vYg==", LENIENT | STRICT },
+    { "+-AA", LENIENT | NOPAD },
+    { "Zm9vYmFy/_", LENIENT | NOPAD },
+    { "A", 0 },
+    { "Zm9vY", 0 },
+    { "A=A=", 0 },
+    { "#!/b", 0 },
+};
+
+static const struct {
+    const char *name;
+    int (*decode)(const char*, size_t, uint8_t*);
+} decoders[] = {
+    { "fb64_decode", fb64_decode },
+    { "fb64_decode_cold", fb64_decode_cold },
+    { "fb64_decode_nt", fb64_decode_nt },
+};
+
+static const struct {
+    const char *name;
+    void (*encode)(const uint8_t*, size_t, char*);
+    void (*encode_nt)(const uint8_t*, size_t, char*);
+} nt_encoders[] = {
+    { "fb64_encode_nt", fb64_encode, fb64_encode_nt },
+    { "fb64_encode_nopad_nt", fb64_encode_nopad, fb64_encode_nopad_nt },
+    { "fb64_encode_base64url_nt", fb64_encode_base64url, fb64_encode_base64url_nt },
+    { "fb64_encode_base64url_nopad_nt", fb64_encode_base64url_nopad, fb64_encode_base64url_nopad_nt },
+};
+
+static const struct {
+    size_t size;
+    int (*decode)(const char*, size_t, uint8_t*);
+    void (*encode[4])(const uint8_t*, char*);
+} fixed_codecs[] = {
+    { 16, fb64_decode_16, { fb64_encode_16, fb64_encode_nopad_16,
+        fb64_encode_base64url_16, fb64_encode_base64url_nopad_16 } },
+    { 32, fb64_decode_32, { fb64_encode_32, fb64_encode_nopad_32,
+        fb64_encode_base64url_32, fb64_encode_base64url_nopad_32 } },
+    { 64, fb64_decode_64, { fb64_encode_64, fb64_encode_nopad_64,
+        fb64_encode_base64url_64, fb64_encode_base64url_nopad_64 } },
+};
+
+// Fixed-size functions must match the generic ones for their size & reject
+// encodings of any other size.
+static bool test_fixed(void) {
+    // same order as fixed_codecs[].encode
+    static void (*const generic[4])(const uint8_t*, size_t, char*) = {
+        fb64_encode, fb64_encode_nopad,
+        fb64_encode_base64url, fb64_encode_base64url_nopad,
+    };
+    uint8_t raw[64], decoded[64 + 3];
+    char expect[88], encoded[88];
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(raw); ++i)
+        raw[i] = (uint8_t)(i * 37 + 11);
+
+    for (size_t f = 0; f < sizeof(fixed_codecs) / sizeof(fixed_codecs[0]); ++f) {
+        const size_t n = fixed_codecs[f].size;
+
+        for (size_t e = 0; e < 4; ++e) {
+            const size_t enclen = e % 2 == 0 ? fb64_encoded_size(n) : fb64_encoded_size_nopad(n);
+
+            generic[e](raw, n, expect);
+            fixed_codecs[f].encode[e](raw, encoded);
+            if (memcmp(encoded, expect, enclen) != 0) {
+                ok = false;
+                fprintf(stderr, "Fixed-size encode %zu of %zu bytes was %.*s; expected %.*s\n",
+                        e, n, (int)enclen, encoded, (int)enclen, expect);
+                continue;
+            }
+
+            memset(decoded, 0, sizeof(decoded));
+            if (fixed_codecs[f].decode(encoded, enclen, decoded) != 0 ||
+                    memcmp(decoded, raw, n) != 0) {
+                ok = false;
+                fprintf(stderr, "fb64_decode_%zu: Failed to decode %.*s\n", n, (int)enclen, encoded);
+            }
+
+            // Encodings of other sizes
+            for (size_t len = enclen - 3; len <= enclen + 3; ++len) {
+                if (len == fb64_encoded_size(n) || len == fb64_encoded_size_nopad(n))
+                    continue;
+
+                if (fixed_codecs[f].decode(encoded, len, decoded) == 0) {
+                    ok = false;
+                    fprintf(stderr, "fb64_decode_%zu: Accepted input of length %zu\n", n, len);
+                }
+            }
+        }
+
+        // Bad padding
+        fb64_encode(raw, n, encoded);
+        encoded[fb64_encoded_size(n) - 1] = 'A';
+        if (fixed_codecs[f].decode(encoded, fb64_encoded_size(n), decoded) == 0) {
+            ok = false;
+            fprintf(stderr, "fb64_decode_%zu: Accepted bad padding\n", n);
+        }
+    }
+
+    return ok;
+}
+
+// Non-temporal variants must give the same output as the regular
+// functions at every output alignment, on inputs long enough to
+// reach the streaming loop.
+static bool test_nt(void) {
+    static uint8_t raw[1000 + 3];
+    static char encoded[1336 + 3], encoded_nt[1336 + 3];
+    static uint8_t decoded[1000 + 3];
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(raw); ++i)
+        raw[i] = (uint8_t)(i * 7 + 3);
+
+    for (size_t e = 0; e < sizeof(nt_encoders) / sizeof(nt_encoders[0]); ++e) {
+        for (size_t offset = 0; offset < 4; ++offset) {
+            for (size_t len = 990; len <= 1000; ++len) {
+                nt_encoders[e].encode(raw, len, encoded);
+                nt_encoders[e].encode_nt(raw, len, encoded_nt + offset);
+
+                size_t enclen = nt_encoders[e].encode == fb64_encode_nopad ||
+                    nt_encoders[e].encode == fb64_encode_base64url_nopad ?
+                    fb64_encoded_size_nopad(len) : fb64_encoded_size(len);
+
+                if (memcmp(encoded, encoded_nt + offset, enclen) != 0) {
+                    ok = false;
+                    fprintf(stderr, "%s: Output mismatch at offset %zu, length %zu\n", nt_encoders[e].name, offset, len);
+                    continue;
+                }
+
+                memset(decoded, 0, sizeof(decoded));
+                if (fb64_decode_nt(encoded, enclen, decoded + offset) != 0 ||
+                        memcmp(decoded + offset, raw, len) != 0) {
+                    ok = false;
+                    fprintf(stderr, "fb64_decode_nt: Failed to decode %s output at offset %zu, length %zu\n", nt_encoders[e].name, offset, len);
+                }
+            }
+        }
+    }
+
+    // Bad symbols must be detected inside the streaming loop too.
+    fb64_encode(raw, 999, encoded);
+    encoded[500] = '!';
+    if (fb64_decode_nt(encoded, fb64_encoded_size(999), decoded) == 0) {
+        ok = false;
+        fprintf(stderr, "fb64_decode_nt: Expected invalid symbol to fail\n");
+    }
+
+    return ok;
+}
+
+static const struct {
+    uint64_t hi, lo;
+    const char *u64, *u128;
+} id_tests[] = {
+    { 0, 0, "AAAAAAAAAAA", "AAAAAAAAAAAAAAAAAAAAAA" },
+    { UINT64_MAX, UINT64_MAX, "__________8", "_____________________w" },
+    { 0x0123456789abcdef, 0xfedcba9876543210, "ASNFZ4mrze8", "ASNFZ4mrze_-3LqYdlQyEA" },
+    { 1, 0x8000000000000000, "AAAAAAAAAAE", "AAAAAAAAAAGAAAAAAAAAAA" },
+};
+
+static const char *const bad_ids[] = {
+    "AAAAAAAAAAB",  // spare bits set
+    "AAAAAAAAAA+",  // standard alphabet
+    "AAAAAAAAAA=",
+    "AAAAAA AAAA",
+    "AAAAAAAAAA",
+    "AAAAAAAAAAAA",
+    "AAAAAAAAAAAAAAAAAAAAAB",
+    "AAAAAAAAAAAAAAAAAAAA/A",
+    "AAAAAAAAAAA\xc1" "AAAAAAAAAA",
+};
+
+// Integer IDs, individually & in batches of every size up to a few vectors
+static bool test_ids(void) {
+    static uint64_t ids[2 * 40], decoded[2 * 40];
+    static char encoded[FB64_U128_LEN * 40], single[FB64_U128_LEN * 40];
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(id_tests) / sizeof(id_tests[0]); ++i) {
+        char out[FB64_U128_LEN];
+        uint64_t hi, lo;
+
+        fb64_encode_u64(id_tests[i].hi, out);
+        if (memcmp(out, id_tests[i].u64, FB64_U64_LEN) != 0 ||
+                fb64_decode_u64(id_tests[i].u64, FB64_U64_LEN, &hi) != 0 || hi != id_tests[i].hi) {
+            ok = false;
+            fprintf(stderr, "fb64_encode_u64: Encoded %#llx as %.11s, expected %s\n",
+                    (unsigned long long)id_tests[i].hi, out, id_tests[i].u64);
+        }
+
+        fb64_encode_u128(id_tests[i].hi, id_tests[i].lo, out);
+        if (memcmp(out, id_tests[i].u128, FB64_U128_LEN) != 0 ||
+                fb64_decode_u128(id_tests[i].u128, FB64_U128_LEN, &hi, &lo) != 0 ||
+                hi != id_tests[i].hi || lo != id_tests[i].lo) {
+            ok = false;
+            fprintf(stderr, "fb64_encode_u128: Encoded %#llx %#llx as %.22s, expected %s\n",
+                    (unsigned long long)id_tests[i].hi, (unsigned long long)id_tests[i].lo, out, id_tests[i].u128);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(bad_ids) / sizeof(bad_ids[0]); ++i) {
+        const char *in = bad_ids[i];
+        uint64_t hi, lo;
+        int err = strlen(in) <= FB64_U64_LEN + 1 ?
+            fb64_decode_u64(in, strlen(in), &hi) : fb64_decode_u128(in, strlen(in), &hi, &lo);
+        int batch_err = strlen(in) == FB64_U64_LEN ? fb64_decode_u64_batch(in, 1, &hi) :
+            strlen(in) == FB64_U128_LEN ? fb64_decode_u128_batch(in, 1, decoded) : 1;
+        if (!err || !batch_err) {
+            ok = false;
+            fprintf(stderr, "fb64_decode_u64/u128: Accepted %s\n", in);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i)
+        ids[i] = (uint64_t)i * 0x9e3779b97f4a7c15u;
+
+    for (size_t n = 0; n <= 40; ++n) {
+        fb64_encode_u64_batch(ids, n, encoded);
+        for (size_t i = 0; i < n; ++i)
+            fb64_encode_u64(ids[i], single + i * FB64_U64_LEN);
+
+        if (memcmp(encoded, single, n * FB64_U64_LEN) != 0 ||
+                fb64_decode_u64_batch(encoded, n, decoded) != 0 ||
+                memcmp(decoded, ids, n * sizeof(ids[0])) != 0) {
+            ok = false;
+            fprintf(stderr, "fb64_encode_u64_batch: Round trip mismatch for %zu IDs\n", n);
+        }
+
+        fb64_encode_u128_batch(ids, n, encoded);
+        for (size_t i = 0; i < n; ++i)
+            fb64_encode_u128(ids[i * 2], ids[i * 2 + 1], single + i * FB64_U128_LEN);
+
+        if (memcmp(encoded, single, n * FB64_U128_LEN) != 0 ||
+                fb64_decode_u128_batch(encoded, n, decoded) != 0 ||
+                memcmp(decoded, ids, n * 2 * sizeof(ids[0])) != 0) {
+            ok = false;
+            fprintf(stderr, "fb64_encode_u128_batch: Round trip mismatch for %zu IDs\n", n);
+        }
+
+        // A bad symbol in any ID fails the batch
+        if (n > 0) {
+            encoded[(n - 1) * FB64_U128_LEN + 5] = '/';
+            if (fb64_decode_u128_batch(encoded, n, decoded) == 0) {
+                ok = false;
+                fprintf(stderr, "fb64_decode_u128_batch: Accepted bad symbol in ID %zu\n", n - 1);
+            }
+        }
+    }
+
+    return ok;
+}
+
+static bool test_records(void) {
+    static const char input[] = "Zm9v\nYmFy\r\n\nZg==\nZm9v!\nSGVsbG8sIHdvcmxkIQ\n";
+    static const struct {
+        const char *decoded;
+        bool error;
+    } expect[] = {
+        { "foo" }, { "bar" }, { "" }, { "f" }, { "", true }, { "Hello, world!" },
+    };
+    const size_t nexpect = sizeof(expect) / sizeof(expect[0]);
+    uint8_t out[sizeof(input)];
+    struct fb64_record records[8];
+    size_t consumed;
+    bool ok = true;
+
+    // All at once, then a few records per call
+    for (size_t max = 8; max > 0; max /= 2) {
+        size_t done = 0, n = 0;
+        size_t outlen = 0;
+
+        while (done < sizeof(input) - 1) {
+            size_t got = fb64_decode_records(input + done, sizeof(input) - 1 - done, '\n',
+                    out, records, max, &consumed);
+
+            for (size_t r = 0; r < got && n < nexpect; ++r, ++n) {
+                const char *dec = expect[n].decoded;
+                if (!records[r].err != !expect[n].error ||
+                        records[r].len != strlen(dec) ||
+                        memcmp(out + records[r].offset, dec, strlen(dec)) != 0) {
+                    ok = false;
+                    fprintf(stderr, "fb64_decode_records: Record %zu mismatch with %zu records per call\n", n, max);
+                }
+                outlen = records[r].offset + records[r].len;
+            }
+
+            if (got == 0 || n > nexpect)
+                break;
+            done += consumed;
+        }
+
+        if (n != nexpect || outlen > fb64_decoded_size_nopad(sizeof(input) - 1)) {
+            ok = false;
+            fprintf(stderr, "fb64_decode_records: Decoded %zu records with %zu records per call, expected %zu\n", n, max, nexpect);
+        }
+    }
+
+    // Unterminated final record
+    if (fb64_decode_records("Zm9v,YmFy", 9, ',', out, records, 8, &consumed) != 2 ||
+            consumed != 9 || records[1].len != 3 || memcmp(out + records[1].offset, "bar", 3) != 0) {
+        ok = false;
+        fprintf(stderr, "fb64_decode_records: Failed to decode unterminated record\n");
+    }
+
+    // Encoding, in each variant & a few records per call
+    static const char raw[] = "foo\nb\n\n\xfb\xff\nHello, world!";
+    static const char *const encoded[][5] = {
+        { "Zm9v", "Yg==", "", "+/8=", "SGVsbG8sIHdvcmxkIQ==" },
+        { "Zm9v", "Yg", "", "-_8", "SGVsbG8sIHdvcmxkIQ" },
+    };
+    static const unsigned flags[] = { 0, FB64_RECORD_URL | FB64_RECORD_NOPAD };
+    char text[(sizeof(raw) - 1) * 2 + 2];
+
+    for (size_t f = 0; f < 2; ++f) {
+        for (size_t max = 8; max > 0; max /= 2) {
+            size_t done = 0, n = 0;
+
+            while (done < sizeof(raw) - 1 && n < 5) {
+                size_t got = fb64_encode_records((const uint8_t*)raw + done, sizeof(raw) - 1 - done, '\n',
+                        flags[f], text, records, max, &consumed);
+
+                for (size_t r = 0; r < got && n < 5; ++r, ++n) {
+                    const char *expect = encoded[f][n];
+                    if (records[r].err || records[r].len != strlen(expect) ||
+                            memcmp(text + records[r].offset, expect, strlen(expect)) != 0) {
+                        ok = false;
+                        fprintf(stderr, "fb64_encode_records: Record %zu mismatch with flags %u & %zu records per call\n", n, flags[f], max);
+                    }
+                }
+
+                if (got == 0)
+                    break;
+                done += consumed;
+            }
+
+            if (n != 5 || done != sizeof(raw) - 1) {
+                ok = false;
+                fprintf(stderr, "fb64_encode_records: Encoded %zu records with flags %u & %zu records per call\n", n, flags[f], max);
+            }
+        }
+    }
+
+    return ok;
+}
+
+// Resumable decode into small output buffers must produce the same bytes as
+// one fb64_decode() call, & never more than fit.
+static bool test_partial(void) {
+    static const char *const inputs[] = {
+        "", "Zg==", "Zm8", "Zm9vYmFy", "SGVsbG8sIHdvcmxkIQ==", "SGVsbG8sIHdvcmxkIQ",
+        "QmFzZTY0IGRlY29kaW5nIGludG8gYnVmZmVycyBvZiBsaW1pdGVkIHNpemU=",
+    };
+    static const size_t caps[] = { 3, 4, 5, 6, 7, 12, 13, 100 };
+    uint8_t expect[64], out[128];
+    size_t consumed, produced;
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+        const char *in = inputs[i];
+        const size_t len = strlen(in);
+        const size_t declen = fb64_decoded_size(in, len);
+
+        if (len && fb64_decode(in, len, expect) != 0) {
+            ok = false;
+            fprintf(stderr, "fb64_decode_partial: Bad test input %s\n", in);
+            continue;
+        }
+
+        for (size_t c = 0; c < sizeof(caps) / sizeof(caps[0]); ++c) {
+            size_t done = 0, outlen = 0;
+
+            memset(out, 0xff, sizeof(out));
+            do {
+                if (fb64_decode_partial(in + done, len - done, out + outlen, caps[c],
+                            &consumed, &produced) != 0 || produced > caps[c] ||
+                        (done < len && consumed == 0)) {
+                    ok = false;
+                    fprintf(stderr, "fb64_decode_partial: Failed on %s at %zu with capacity %zu\n", in, done, caps[c]);
+                    break;
+                }
+                done += consumed;
+                outlen += produced;
+            } while (done < len);
+
+            if (outlen != declen || memcmp(out, expect, declen) != 0 || out[declen] != 0xff) {
+                ok = false;
+                fprintf(stderr, "fb64_decode_partial: Mismatch decoding %s with capacity %zu\n", in, caps[c]);
+            }
+        }
+    }
+
+    // Too little room for the next block
+    if (fb64_decode_partial("Zm9v", 4, out, 2, &consumed, &produced) != 0 ||
+            consumed != 0 || produced != 0) {
+        ok = false;
+        fprintf(stderr, "fb64_decode_partial: Decoded a block that doesn't fit\n");
+    }
+
+    // Padding is only allowed in the final block, however the input is split
+    if (fb64_decode_partial("Zg==Zm9v", 8, out, 3, &consumed, &produced) == 0 ||
+            consumed != 0 || produced != 0) {
+        ok = false;
+        fprintf(stderr, "fb64_decode_partial: Accepted padding before the final block\n");
+    }
+
+    return ok;
+}
+
+// RFC 4648 section 10 test vectors
+static const struct {
+    const char *raw, *base16, *base32, *base32hex;
+} rfc4648_tests[] = {
+    { "", "", "", "" },
+    { "f", "66", "MY======", "CO======" },
+    { "fo", "666F", "MZXQ====", "CPNG====" },
+    { "foo", "666F6F", "MZXW6===", "CPNMU===" },
+    { "foob", "666F6F62", "MZXW6YQ=", "CPNMUOG=" },
+    { "fooba", "666F6F6261", "MZXW6YTB", "CPNMUOJ1" },
+    { "foobar", "666F6F626172", "MZXW6YTBOI======", "CPNMUOJ1E8======" },
+};
+
+static const struct {
+    const char *encoded;
+    int (*decode)(const char*, size_t, uint8_t*);
+} bad_base16_32[] = {
+    { "6", fb64_base16_decode },
+    { "6G", fb64_base16_decode },
+    { "666F6F626172666F6F626172666F6F62617266 F", fb64_base16_decode },
+    { "M", fb64_base32_decode },
+    { "MZX", fb64_base32_decode },
+    { "MZXW6Y", fb64_base32_decode },
+    { "MZXW6YTB1", fb64_base32_decode },
+    { "MZXW6Y==", fb64_base32_decode },
+    { "MZ=W6YQ=", fb64_base32_decode },
+    { "M=======", fb64_base32_decode },
+    { "CPNMUOJW", fb64_base32hex_decode },
+    { "CPNMUOJ1E", fb64_base32hex_decode },
+};
+
+// Base16 & base32: encoding, size functions & decoding with & without
+// padding, in either case. Long inputs reach the vectorized loops.
+static bool test_base16_32(void) {
+    static uint8_t raw[200], decoded[200];
+    static char encoded[400], lower[400];
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(rfc4648_tests) / sizeof(rfc4648_tests[0]); ++i) {
+        const char *in = rfc4648_tests[i].raw;
+        const size_t len = strlen(in);
+        const struct {
+            const char *name, *expect;
+            void (*encode)(const uint8_t*, size_t, char*);
+            void (*encode_nopad)(const uint8_t*, size_t, char*);
+            int (*decode)(const char*, size_t, uint8_t*);
+        } codecs[] = {
+            { "base16", rfc4648_tests[i].base16, fb64_base16_encode, fb64_base16_encode, fb64_base16_decode },
+            { "base32", rfc4648_tests[i].base32, fb64_base32_encode, fb64_base32_encode_nopad, fb64_base32_decode },
+            { "base32hex", rfc4648_tests[i].base32hex, fb64_base32hex_encode, fb64_base32hex_encode_nopad, fb64_base32hex_decode },
+        };
+
+        for (size_t c = 0; c < sizeof(codecs) / sizeof(codecs[0]); ++c) {
+            const char *expect = codecs[c].expect;
+            const bool base16 = c == 0;
+            const size_t enclen = base16 ? fb64_base16_encoded_size(len) : fb64_base32_encoded_size(len);
+            const size_t nopad_len = base16 ? enclen : fb64_base32_encoded_size_nopad(len);
+
+            memset(encoded, 0, sizeof(encoded));
+            codecs[c].encode((const uint8_t*)in, len, encoded);
+            if (enclen != strlen(expect) || strcmp(encoded, expect) != 0) {
+                ok = false;
+                fprintf(stderr, "fb64_%s_encode: Encoded %s as %s, expected %s\n", codecs[c].name, in, encoded, expect);
+            }
+
+            memset(encoded, 0, sizeof(encoded));
+            codecs[c].encode_nopad((const uint8_t*)in, len, encoded);
+            if (strlen(encoded) != nopad_len || strncmp(encoded, expect, nopad_len) != 0 ||
+                    (expect[nopad_len] != '\0' && expect[nopad_len] != '=')) {
+                ok = false;
+                fprintf(stderr, "fb64_%s_encode_nopad: Encoded %s as %s\n", codecs[c].name, in, encoded);
+            }
+
+            for (size_t j = 0; j <= strlen(expect); ++j)
+                lower[j] = (char)(expect[j] >= 'A' && expect[j] <= 'Z' ? expect[j] + 32 : expect[j]);
+
+            // Either case, with & without padding
+            const char *inputs[] = { expect, lower };
+            const size_t lengths[] = { nopad_len, enclen };
+            for (size_t v = 0; v < 2; ++v) {
+                for (size_t n = 0; n < 2; ++n) {
+                    const size_t l = lengths[n];
+                    const size_t declen = base16 ? fb64_base16_decoded_size(l) :
+                        fb64_base32_decoded_size(inputs[v], l);
+                    memset(decoded, 0xff, sizeof(decoded));
+                    if (codecs[c].decode(inputs[v], l, decoded) != 0 || declen != len ||
+                            memcmp(decoded, in, len) != 0 || decoded[len] != 0xff) {
+                        ok = false;
+                        fprintf(stderr, "fb64_%s_decode: Failed to decode %.*s\n", codecs[c].name, (int)l, inputs[v]);
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(bad_base16_32) / sizeof(bad_base16_32[0]); ++i) {
+        const char *in = bad_base16_32[i].encoded;
+        if (bad_base16_32[i].decode(in, strlen(in), decoded) == 0) {
+            ok = false;
+            fprintf(stderr, "Invalid base16/32 input %s was accepted\n", in);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(raw); ++i)
+        raw[i] = (uint8_t)(i * 151 + 17);
+
+    for (size_t len = sizeof(raw) - 40; len <= sizeof(raw); ++len) {
+        fb64_base16_encode_lower(raw, len, encoded);
+        if (fb64_base16_decode(encoded, len * 2, decoded) != 0 || memcmp(decoded, raw, len) != 0) {
+            ok = false;
+            fprintf(stderr, "fb64_base16_decode: Round trip mismatch for %zu bytes\n", len);
+        }
+
+        fb64_base32hex_encode_nopad(raw, len, encoded);
+        if (fb64_base32hex_decode(encoded, fb64_base32_encoded_size_nopad(len), decoded) != 0 ||
+                memcmp(decoded, raw, len) != 0) {
+            ok = false;
+            fprintf(stderr, "fb64_base32hex_decode: Round trip mismatch for %zu bytes\n", len);
+        }
+    }
+
+    // Bad digits must be found inside the vectorized loop too
+    fb64_base16_encode(raw, 100, encoded);
+    encoded[41] = 'g';
+    if (fb64_base16_decode(encoded, 200, decoded) == 0) {
+        ok = false;
+        fprintf(stderr, "fb64_base16_decode: Accepted bad digit in a long input\n");
+    }
+
+    return ok;
+}
+
+// Every short length, checking that nothing is written past the end of the
+// output by the tail handling.
+static bool test_tails(void) {
+    static const uint8_t canary = 0xa5;
+    uint8_t raw[24], decoded[24 + 4];
+    char encoded[32 + 4];
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(raw); ++i)
+        raw[i] = (uint8_t)(0xff - i * 11);
+
+    for (size_t len = 0; len <= sizeof(raw); ++len) {
+        for (int pad = 0; pad < 2; ++pad) {
+            const size_t enclen = pad ? fb64_encoded_size(len) : fb64_encoded_size_nopad(len);
+
+            memset(encoded, canary, sizeof(encoded));
+            (pad ? fb64_encode : fb64_encode_nopad)(raw, len, encoded);
+            if (encoded[enclen] != (char)canary) {
+                ok = false;
+                fprintf(stderr, "%s: Wrote past the end of the output for length %zu\n",
+                        pad ? "fb64_encode" : "fb64_encode_nopad", len);
+            }
+
+            for (size_t d = 0; d < 2; ++d) {
+                int (*decode)(const char*, size_t, uint8_t*) = d ? fb64_decode_nopad : fb64_decode;
+                if (pad && decode == fb64_decode_nopad && enclen != fb64_encoded_size_nopad(len))
+                    continue;
+
+                memset(decoded, canary, sizeof(decoded));
+                if (decode(encoded, enclen, decoded) != 0 || memcmp(decoded, raw, len) != 0 ||
+                        decoded[len] != canary) {
+                    ok = false;
+                    fprintf(stderr, "%s: Failed to decode %zu bytes %s padding\n",
+                            d ? "fb64_decode_nopad" : "fb64_decode", len, pad ? "with" : "without");
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
 int main(void) {
     uint8_t buf[123];
 
     bool ok = true;
 
-    for (size_t i = 0; i < sizeof(decode_tests) / sizeof(decode_tests[0]); ++i) {
-        // dirty the output buffer so we have a good chance of detecting whether
-        // the output length (buflen) is too long (except if the input was
-        // all-ones).
-        memset(buf, '\xff', sizeof(buf));
-        size_t outlen = fb64_decoded_size(decode_tests[i].encoded, strlen(decode_tests[i].encoded));
-        int err = fb64_decode(decode_tests[i].encoded, strlen(decode_tests[i].encoded), (uint8_t*)buf);
-        if (err && !decode_tests[i].error) {
+    for (size_t d = 0; d < sizeof(decoders) / sizeof(decoders[0]); ++d) {
+        for (size_t i = 0; i < sizeof(decode_tests) / sizeof(decode_tests[0]); ++i) {
+            // dirty the output buffer so we have a good chance of detecting whether
+            // the output length (buflen) is too long (except if the input was
+            // all-ones).
+            memset(buf, '\xff', sizeof(buf));
+            size_t outlen = fb64_decoded_size(decode_tests[i].encoded, strlen(decode_tests[i].encoded));
+            int err = decoders[d].decode(decode_tests[i].encoded, strlen(decode_tests[i].encoded), (uint8_t*)buf);
+            if (err && !decode_tests[i].error) {
+                ok = false;
+                fprintf(stderr, "%s: Test input %s failed to decode correctly\n", decoders[d].name, decode_tests[i].encoded);
+                continue;
+            } else if (!err && decode_tests[i].error) {
+                ok = false;
+                fprintf(stderr, "%s: Expeted test %s to fail but it succeeded\n", decoders[d].name, decode_tests[i].encoded);
+                continue;
+            }
+
+            if (decode_tests[i].error)
+                continue; // skip tests on invalid encoded input: nothing to check agaist
+
+            if (memcmp(buf, decode_tests[i].decoded, outlen) != 0) {
+                ok = false;
+                fprintf(stderr, "%s: Decode mismatch on input %s, got length %zu: [%.*s]\n", decoders[d].name, decode_tests[i].encoded, outlen, (int)outlen, buf);
+                continue;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(json_tests) / sizeof(json_tests[0]); ++i) {
+        uint8_t expect[123];
+        size_t outlen = 0;
+        size_t expect_len = fb64_decoded_size(json_tests[i].unescaped, strlen(json_tests[i].unescaped));
+
+        int err = fb64_decode_json(json_tests[i].json, strlen(json_tests[i].json), buf, &outlen);
+        if (!err != !json_tests[i].error) {
             ok = false;
-            fprintf(stderr, "Test input %s failed to decode correctly\n", decode_tests[i].encoded);
+            fprintf(stderr, "fb64_decode_json: Test input %s %s\n", json_tests[i].json,
+                    err ? "failed to decode correctly" : "was expected to fail but succeeded");
             continue;
-        } else if (!err && decode_tests[i].error) {
-            ok = false;
-            fprintf(stderr, "Expeted test %s to fail but it succeeded\n", decode_tests[i].encoded);
+        }
+
+        if (json_tests[i].error)
             continue;
+
+        fb64_decode(json_tests[i].unescaped, strlen(json_tests[i].unescaped), expect);
+        if (outlen != expect_len || memcmp(buf, expect, outlen) != 0) {
+            ok = false;
+            fprintf(stderr, "fb64_decode_json: Decode mismatch on input %s, got length %zu\n", json_tests[i].json, outlen);
         }
+    }
 
-        if (decode_tests[i].error)
-            continue; // skip tests on invalid encoded input: nothing to check agaist
+    for (size_t i = 0; i < sizeof(equals_tests) / sizeof(equals_tests[0]); ++i) {
+        const char *in = equals_tests[i].encoded, *expect = equals_tests[i].expected;
+        bool equal = fb64_decode_equals(in, strlen(in), (const uint8_t*)expect, strlen(expect)) == 0;
+        if (equal != equals_tests[i].equal) {
+            ok = false;
+            fprintf(stderr, "fb64_decode_equals: Input %s %s %s\n", in,
+                    equal ? "matched" : "didn't match", expect);
+        }
+    }
 
-        if (memcmp(buf, decode_tests[i].decoded, outlen) != 0) {
+    for (size_t i = 0; i < sizeof(classify_tests) / sizeof(classify_tests[0]); ++i) {
+        unsigned result = fb64_classify(classify_tests[i].input, strlen(classify_tests[i].input));
+        if (result != classify_tests[i].expect) {
             ok = false;
-            fprintf(stderr, "Decode mismatch on input %s, got length %zu: [%.*s]\n", decode_tests[i].encoded, outlen, (int)outlen, buf);
-            continue;
+            fprintf(stderr, "fb64_classify: Input %s classified as %#x, expected %#x\n",
+                    classify_tests[i].input, result, classify_tests[i].expect);
+        }
+    }
+
+    // Partial padding is BAD_LENGTH, which strict decoders reject, although
+    // fb64_decode() (& so fb64_decode_partial() etc.) accepts it
+    {
+        uint8_t out[3];
+        if (!(fb64_classify("Zg=", 3) & FB64_CLASS_BAD_LENGTH) ||
+                fb64_decode("Zg=", 3, out) != 0 || out[0] != 'f' ||
+                fb64_decode_strict("Zg=", 3, out) == 0 ||
+                fb64_decode_base64url_strict("Zg=", 3, out) == 0) {
+            ok = false;
+            fprintf(stderr, "fb64_classify: Partial padding not handled as documented\n");
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(policy_tests) / sizeof(policy_tests[0]); ++i) {
+        const char *in = policy_tests[i].encoded;
+        uint8_t expect[123];
+        size_t outlen = fb64_decoded_size(in, strlen(in));
+
+        fb64_decode(in, strlen(in), expect);
+
+        for (size_t d = 0; d < sizeof(policy_decoders) / sizeof(policy_decoders[0]); ++d) {
+            bool accept = policy_tests[i].accepted & (1u << d);
+
+            memset(buf, '\xff', sizeof(buf));
+            int err = policy_decoders[d].decode(in, strlen(in), buf);
+            if (!err != accept) {
+                ok = false;
+                fprintf(stderr, "%s: Input %s was %s\n", policy_decoders[d].name, in,
+                        err ? "rejected" : "accepted");
+            } else if (!err && memcmp(buf, expect, outlen) != 0) {
+                ok = false;
+                fprintf(stderr, "%s: Decode mismatch on input %s\n", policy_decoders[d].name, in);
+            }
+        }
+    }
+
+    // Every decoder must agree with the table decoder on every symbol, in
+    // every position of a block.
+    for (unsigned c = 0; c < 256; ++c) {
+        for (unsigned pos = 0; pos < 4; ++pos) {
+            char block[4] = {'A', 'B', 'C', 'D'};
+            block[pos] = (char)c;
+            uint8_t expect[3], got[3];
+            size_t outlen = fb64_decoded_size(block, sizeof(block));
+            int expect_err = fb64_decode(block, sizeof(block), expect);
+
+            for (size_t d = 1; d < sizeof(decoders) / sizeof(decoders[0]); ++d) {
+                int err = decoders[d].decode(block, sizeof(block), got);
+                if (!err != !expect_err || (!err && memcmp(got, expect, outlen) != 0)) {
+                    ok = false;
+                    fprintf(stderr, "%s: Symbol %u at position %u decoded differently to fb64_decode\n", decoders[d].name, c, pos);
+                }
+            }
         }
     }
 
@@ -150,5 +944,26 @@ int main(void) {
         }
     }
 
+    if (!test_fixed())
+        ok = false;
+
+    if (!test_nt())
+        ok = false;
+
+    if (!test_records())
+        ok = false;
+
+    if (!test_ids())
+        ok = false;
+
+    if (!test_tails())
+        ok = false;
+
+    if (!test_base16_32())
+        ok = false;
+
+    if (!test_partial())
+        ok = false;
+
     return ok ? 0 : 1;
 }
@@ -0,0 +1,324 @@
+/*
+ * This file is part of fb64.
+ *
+ * Copyright (c) 2019 Ted J. Percival
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fb64.hpp"
+
+using namespace std::literals;
+using namespace fb64::literals;
+
+template <std::size_t N>
+constexpr std::string_view view(const std::array<char, N>& a) {
+    return std::string_view(a.data(), N);
+}
+
+template <std::size_t N>
+constexpr bool equal(const std::array<std::uint8_t, N>& a, std::string_view expect) {
+    if (N != expect.size())
+        return false;
+    for (std::size_t i = 0; i < N; ++i)
+        if (a[i] != static_cast<std::uint8_t>(expect[i]))
+            return false;
+    return true;
+}
+
+// RFC 4648 test vectors, at compile time
+static_assert(view(fb64::encode("")) == ""sv);
+static_assert(view(fb64::encode("f")) == "Zg=="sv);
+static_assert(view(fb64::encode("fo")) == "Zm8="sv);
+static_assert(view(fb64::encode("foo")) == "Zm9v"sv);
+static_assert(view(fb64::encode("foob")) == "Zm9vYg=="sv);
+static_assert(view(fb64::encode("fooba")) == "Zm9vYmE="sv);
+static_assert(view(fb64::encode("foobar")) == "Zm9vYmFy"sv);
+static_assert(view(fb64::encode<fb64::alphabet::base64url, fb64::padding::nopad>("f")) == "Zg"sv);
+static_assert(view(fb64::encode<fb64::alphabet::base64, fb64::padding::nopad>("fo")) == "Zm8"sv);
+static_assert(view(fb64::encode(std::array<std::uint8_t, 3>{0xff, 0xff, 0xfe})) == "///+"sv);
+static_assert(view(fb64::encode<fb64::alphabet::base64url>(std::array<std::uint8_t, 3>{0xff, 0xff, 0xfe})) == "___-"sv);
+
+static_assert(equal(""_fb64, ""));
+static_assert(equal("Zg=="_fb64, "f"));
+static_assert(equal("Zm8="_fb64, "fo"));
+static_assert(equal("Zm9vYmE="_fb64, "fooba"));
+static_assert(equal("Zm9vYmFy"_fb64, "foobar"));
+static_assert(equal("Zm9vYg"_fb64, "foob"));
+static_assert(equal("Zg="_fb64, "f"));
+static_assert(equal("SGVsbG8sIHdvcmxkIQ=="_fb64, "Hello, world!"));
+static_assert(equal("++--"_fb64, "\xfb\xef\xbe"));
+static_assert(equal("/_/_"_fb64, "\xff\xff\xff"));
+static_assert(equal(fb64::decode<3>("Zm9v"), "foo"));
+
+static_assert(fb64::encoded_size(32) == 44);
+static_assert(fb64::encoded_size(32, fb64::padding::nopad) == 43);
+static_assert(fb64::decoded_size("Zm8=") == 2);
+
+// The constexpr & C implementations must agree, including on which inputs
+// are invalid.
+static const char *const decode_inputs[] = {
+    "", "Zg==", "Zm8=", "Zm9v", "Zg", "Zm8", "Zg=", "Zm9vYmFy", "-_+/",
+    "A", "A=A=", "Zm9v==", "Zm9v=", "Z===", "#!/bin/bash", "Zm 9v",
+};
+
+// Codec combinations, as bits of codec_tests[].accepted_by
+enum : unsigned {
+    LENIENT_PAD      = 1u << 0, // codec<base64, pad, lenient>
+    LENIENT_NOPAD    = 1u << 1, // codec<base64url, nopad, lenient>
+    STRICT_PAD       = 1u << 2, // codec<base64, pad, strict>
+    STRICT_NOPAD     = 1u << 3, // codec<base64, nopad, strict>
+    URL_STRICT_PAD   = 1u << 4, // codec<base64url, pad, strict>
+    URL_STRICT_NOPAD = 1u << 5, // codec<base64url, nopad, strict>
+    LENIENT = LENIENT_PAD | LENIENT_NOPAD,
+    ALL_CODECS = LENIENT | STRICT_PAD | STRICT_NOPAD | URL_STRICT_PAD | URL_STRICT_NOPAD,
+};
+
+// Fixed expectations for each policy: lenient codecs accept either
+// alphabet, strict ones only their own; padded codecs accept padding (&
+// the lenient one, partial padding or none), unpadded ones reject it.
+static const struct {
+    const char *input;
+    std::string_view decoded;
+    unsigned accepted_by;
+} codec_tests[] = {
+    { "", ""sv, ALL_CODECS },
+    { "Zm9v", "foo"sv, ALL_CODECS },
+    { "Zg==", "f"sv, LENIENT_PAD | STRICT_PAD | URL_STRICT_PAD },
+    { "Zg", "f"sv, LENIENT | STRICT_NOPAD | URL_STRICT_NOPAD },
+    { "Zg=", "f"sv, LENIENT_PAD },
+    { "++//", "\xfb\xef\xff"sv, LENIENT | STRICT_PAD | STRICT_NOPAD },
+    { "--__", "\xfb\xef\xff"sv, LENIENT | URL_STRICT_PAD | URL_STRICT_NOPAD },
+    { "+-AA", "\xfb\xe0\x00"sv, LENIENT },
+    { "A", ""sv, 0 },
+    { "Zm9vYg==", "foob"sv, LENIENT_PAD | STRICT_PAD | URL_STRICT_PAD },
+    { "Zm9vYmE", "fooba"sv, LENIENT | STRICT_NOPAD | URL_STRICT_NOPAD },
+};
+
+// Each codec combination must encode like the equivalent constexpr encode()
+// & accept, reject & decode as in codec_tests.
+template <fb64::alphabet A, fb64::padding P, fb64::strictness S>
+static bool test_codec(const char *name, unsigned self) {
+    using codec = fb64::codec<A, P, S>;
+    static constexpr auto expect_encoded = fb64::encode<A, P>("\xfb\xff\xbf\xff");
+    bool ok = true;
+
+    char encoded[8] = {};
+    codec::encode(reinterpret_cast<const std::uint8_t*>("\xfb\xff\xbf\xff"), 4, encoded);
+    if (codec::encoded_size(4) != expect_encoded.size() ||
+            std::memcmp(encoded, expect_encoded.data(), expect_encoded.size()) != 0) {
+        ok = false;
+        std::fprintf(stderr, "%s: Encoded %.*s\n", name, static_cast<int>(codec::encoded_size(4)), encoded);
+    }
+
+    for (const auto& test: codec_tests) {
+        std::uint8_t out[8];
+        const std::size_t len = std::strlen(test.input);
+        const bool accept = test.accepted_by & self;
+        const bool accepted = codec::decode(test.input, len, out) == 0;
+
+        if (accepted != accept) {
+            ok = false;
+            std::fprintf(stderr, "%s: %s input %s\n", name, accepted ? "Accepted" : "Rejected", test.input);
+        } else if (accepted && (codec::decoded_size(test.input, len) != test.decoded.size() ||
+                    std::memcmp(out, test.decoded.data(), test.decoded.size()) != 0)) {
+            ok = false;
+            std::fprintf(stderr, "%s: Decode mismatch on input %s\n", name, test.input);
+        }
+    }
+
+    return ok;
+}
+
+// Stream codecs & views must produce the same output as the one-shot C
+// functions however the input is split.
+static bool test_stream() {
+    bool ok = true;
+    std::vector<std::uint8_t> raw(10000);
+    for (std::size_t i = 0; i < raw.size(); ++i)
+        raw[i] = static_cast<std::uint8_t>(i * 131 + 7);
+
+    std::string expect(fb64_encoded_size(raw.size()), '\0');
+    fb64_encode(raw.data(), raw.size(), expect.data());
+    std::string expect_url(fb64_encoded_size_nopad(raw.size() - 1), '\0');
+    fb64_encode_base64url_nopad(raw.data(), raw.size() - 1, expect_url.data());
+
+    for (std::size_t chunk: {1, 2, 3, 4, 5, 7, 1000, 10000}) {
+        fb64::stream_encoder<> enc;
+        fb64::stream_encoder<fb64::alphabet::base64url, fb64::padding::nopad> url_enc;
+        std::string encoded, encoded_url;
+        char out[fb64::stream_encoder<>::max_output(10000)];
+
+        for (std::size_t i = 0; i < raw.size(); i += chunk) {
+            const std::size_t n = std::min(chunk, raw.size() - i);
+            encoded.append(out, enc.update(raw.data() + i, n, out));
+            encoded_url.append(out, url_enc.update(raw.data() + i, std::min(n, raw.size() - 1 - i), out));
+        }
+        encoded.append(out, enc.finish(out));
+        encoded_url.append(out, url_enc.finish(out));
+
+        if (encoded != expect || encoded_url != expect_url) {
+            ok = false;
+            std::fprintf(stderr, "fb64::stream_encoder: Output mismatch with %zu byte chunks\n", chunk);
+        }
+
+        fb64::stream_decoder<> dec;
+        std::vector<std::uint8_t> decoded;
+        std::uint8_t dec_out[fb64::stream_decoder<>::max_output(10000)];
+
+        for (std::size_t i = 0; i < expect.size(); i += chunk) {
+            const std::size_t n = std::min(chunk, expect.size() - i);
+            const std::size_t len = dec.update(expect.data() + i, n, dec_out);
+            decoded.insert(decoded.end(), dec_out, dec_out + len);
+        }
+        const std::size_t len = dec.finish(dec_out);
+        decoded.insert(decoded.end(), dec_out, dec_out + len);
+
+        if (dec.failed() || decoded != raw) {
+            ok = false;
+            std::fprintf(stderr, "fb64::stream_decoder: Output mismatch with %zu char chunks\n", chunk);
+        }
+    }
+
+    // Padding is only allowed at the very end
+    for (std::string_view bad: {"Zg==Zg==", "Zm9v!m9v", "Zm9vY"}) {
+        fb64::stream_decoder<> dec;
+        std::uint8_t out[8];
+        dec.update(bad.data(), 3, out);
+        dec.update(bad.data() + 3, bad.size() - 3, out);
+        dec.finish(out);
+        if (!dec.failed()) {
+            ok = false;
+            std::fprintf(stderr, "fb64::stream_decoder: Accepted %.*s\n", static_cast<int>(bad.size()), bad.data());
+        }
+    }
+
+    // Views, from contiguous & non-contiguous ranges
+    std::string view_encoded;
+    for (char c: raw | fb64::views::encode)
+        view_encoded += c;
+
+    std::istringstream in(view_encoded);
+    std::vector<std::uint8_t> view_decoded;
+    for (std::uint8_t b: std::views::istream<char>(in) | fb64::views::decode)
+        view_decoded.push_back(b);
+
+    if (view_encoded != expect || view_decoded != raw) {
+        ok = false;
+        std::fprintf(stderr, "fb64::views: Round trip mismatch\n");
+    }
+
+    std::string url;
+    for (char c: fb64::views::encode_with<fb64::alphabet::base64url, fb64::padding::nopad>(
+                std::string_view("\xff\xff\xfe\xff")))
+        url += c;
+    if (url != "___-_w") {
+        ok = false;
+        std::fprintf(stderr, "fb64::views::encode_with: Encoded %s\n", url.c_str());
+    }
+
+    try {
+        for (std::uint8_t b: std::string_view("Zm9v!m9v") | fb64::views::decode)
+            (void)b;
+        ok = false;
+        std::fprintf(stderr, "fb64::views::decode: Expected invalid input to throw\n");
+    } catch (const std::invalid_argument&) {
+    }
+
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+
+    for (const char *input: decode_inputs) {
+        const std::string_view in(input);
+        std::uint8_t expect[16];
+        std::array<std::uint8_t, 16> buf{};
+        bool bad_c = fb64_decode(in.data(), in.size(), expect) != 0;
+        bool bad_cpp = false;
+
+        try {
+            switch (fb64::decoded_size(in)) {
+            case 0: fb64::decode<0>(in); break;
+            case 1: { auto d = fb64::decode<1>(in); std::memcpy(buf.data(), d.data(), d.size()); break; }
+            case 2: { auto d = fb64::decode<2>(in); std::memcpy(buf.data(), d.data(), d.size()); break; }
+            case 3: { auto d = fb64::decode<3>(in); std::memcpy(buf.data(), d.data(), d.size()); break; }
+            case 6: { auto d = fb64::decode<6>(in); std::memcpy(buf.data(), d.data(), d.size()); break; }
+            case 7: { auto d = fb64::decode<7>(in); std::memcpy(buf.data(), d.data(), d.size()); break; }
+            case 8: { auto d = fb64::decode<8>(in); std::memcpy(buf.data(), d.data(), d.size()); break; }
+            default:
+                std::fprintf(stderr, "Test input %s has an untested decoded size\n", input);
+                ok = false;
+                continue;
+            }
+        } catch (const std::invalid_argument&) {
+            bad_cpp = true;
+        }
+
+        if (bad_c != bad_cpp) {
+            ok = false;
+            std::fprintf(stderr, "fb64::decode: Input %s %s, but fb64_decode() %s\n", input,
+                    bad_cpp ? "failed" : "succeeded", bad_c ? "failed" : "succeeded");
+            continue;
+        }
+
+        if (!bad_c && std::memcmp(buf.data(), expect, fb64::decoded_size(in)) != 0) {
+            ok = false;
+            std::fprintf(stderr, "fb64::decode: Decode mismatch on input %s\n", input);
+        }
+    }
+
+    using fb64::alphabet;
+    using fb64::padding;
+    using fb64::strictness;
+
+    ok &= test_codec<alphabet::base64, padding::pad, strictness::lenient>(
+            "codec<base64, pad, lenient>", LENIENT_PAD);
+    ok &= test_codec<alphabet::base64url, padding::nopad, strictness::lenient>(
+            "codec<base64url, nopad, lenient>", LENIENT_NOPAD);
+    ok &= test_codec<alphabet::base64, padding::pad, strictness::strict>(
+            "codec<base64, pad, strict>", STRICT_PAD);
+    ok &= test_codec<alphabet::base64, padding::nopad, strictness::strict>(
+            "codec<base64, nopad, strict>", STRICT_NOPAD);
+    ok &= test_codec<alphabet::base64url, padding::pad, strictness::strict>(
+            "codec<base64url, pad, strict>", URL_STRICT_PAD);
+    ok &= test_codec<alphabet::base64url, padding::nopad, strictness::strict>(
+            "codec<base64url, nopad, strict>", URL_STRICT_NOPAD);
+
+    ok &= test_stream();
+
+    // Throwing makes invalid input a compile error in constant expressions,
+    // but it must still throw at runtime.
+    try {
+        fb64::decode<3>("Zm9!"sv);
+        ok = false;
+        std::fprintf(stderr, "fb64::decode: Expected invalid input to throw\n");
+    } catch (const std::invalid_argument&) {
+    }
+
+    return ok ? 0 : 1;
+}